@@ -0,0 +1,18 @@
+/*
+ * Binary log events of the border router. The comment of each event is
+ * the format tools/binlog-decode.py prints its arguments with. All of
+ * them are debug events (BINLOG_LEVEL_DEBUG).
+ */
+
+#ifndef BINLOG_EVENTS_H_
+#define BINLOG_EVENTS_H_
+
+#include "binlog.h"
+
+#define EV_SAMPLE             1  /* sampled temperature %d (x100) at %d s */
+#define EV_DECIMATED          2  /* decimated %d/%d reads */
+#define EV_PROXY_JOIN         3  /* proxy: joining fetch %d */
+#define EV_PROXY_RELAY        4  /* proxy: relay %d observes its target */
+#define EV_PROXY_RELEASE      5  /* proxy: releasing relay %d */
+
+#endif /* BINLOG_EVENTS_H_ */
@@ -7,6 +7,7 @@
 #include "contiki-net.h"
 #include "net/uip-ds6.h"
 #include "net/rpl/rpl.h"
+#include "net/rpl/rpl-private.h"
 
 #include "net/netstack.h"
 #include "dev/button-sensor.h"
@@ -15,10 +16,14 @@
 #include "dev/leds.h"
 
 #include "rest-engine.h"
+#include "er-coap-engine.h"
+#include "binlog-events.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
+#include <limits.h>
 #include <ctype.h>
 
 #define DEBUG 0 //DEBUG_NONE
@@ -34,18 +39,93 @@
 #define PRINT6ADDR(addr)
 #endif
 
-#define DELTA_USB_TEMP 2
-#define DELTA_FIX_TEMP 3.76
+/*
+ * Calibration offsets in centi-degrees, subtracted from the raw TMP102 value.
+ * Kept in fixed-point so that no soft-float code ends up in the image; both
+ * can be changed at runtime through the temperature/calibration resource.
+ */
+#define DELTA_USB_TEMP 200
+#define DELTA_FIX_TEMP 376
+static int16_t delta_usb_temp = DELTA_USB_TEMP;
+static int16_t delta_fix_temp = DELTA_FIX_TEMP;
+
+/*
+ * The TMP102 is read by the sampler process on its own schedule, the CoAP
+ * handlers only serve the cached value. This way the I2C bus is read once
+ * per period whatever the number of observers and GET requests.
+ */
+#ifndef TEMPERATURE_CONF_SAMPLE_PERIOD
+#define TEMPERATURE_SAMPLE_PERIOD (5 * CLOCK_SECOND)
+#else
+#define TEMPERATURE_SAMPLE_PERIOD TEMPERATURE_CONF_SAMPLE_PERIOD
+#endif
+
+/*
+ * Each reported sample is decimated from `oversampling` reads spread over the
+ * sample period, either averaged or median-filtered. In mean mode, reads
+ * further than `outlier_reject` centi-degrees from the median are dropped
+ * (0 disables the rejector). Configured through temperature/filter.
+ */
+#ifndef TEMPERATURE_CONF_MAX_OVERSAMPLING
+#define TEMPERATURE_MAX_OVERSAMPLING 8
+#else
+#define TEMPERATURE_MAX_OVERSAMPLING TEMPERATURE_CONF_MAX_OVERSAMPLING
+#endif
+#define DEFAULT_OVERSAMPLING 4
+#define DEFAULT_OUTLIER_REJECT 50
+
+enum { FILTER_MEAN, FILTER_MEDIAN };
+static uint8_t oversampling = DEFAULT_OVERSAMPLING;
+static uint8_t filter_mode = FILTER_MEAN;
+static uint16_t outlier_reject = DEFAULT_OUTLIER_REJECT;
+
+struct temp_sample {
+  int16_t raw;            /* raw TMP102 value, in centi-degrees */
+  unsigned long time;     /* clock_seconds() when it was read */
+};
+static struct temp_sample last_sample;
+static uint8_t sample_ready;  /* last_sample holds a real read */
 static uip_ipaddr_t prefix;
 static uint8_t prefix_set;
 
+/*
+ * Configuration asked from the host through the SLIP bridge. The prefix is
+ * required; the other keys are only asked during the first rounds since
+ * older hosts do not know them:
+ *   C  radio channel, if the platform gives BORDER_ROUTER_CONF_SET_CHANNEL
+ *   D  RPL instance, DIO interval min and DIO interval doublings
+ * Each round of requests has its own sequence number, and only answers to
+ * the current round are used, until the prefix has been received.
+ * Retries back off exponentially from CONFIG_RETRY_MIN to CONFIG_RETRY_MAX.
+ */
+void slip_config_request(uint8_t key, uint8_t seq);
+#ifdef BORDER_ROUTER_CONF_SET_CHANNEL
+/* the channel setter of the radio driver, e.g. cc2420_set_channel() */
+int BORDER_ROUTER_CONF_SET_CHANNEL(int channel);
+#endif
+#define CONFIG_RETRY_MIN      CLOCK_SECOND
+#define CONFIG_RETRY_MAX      (16 * CLOCK_SECOND)
+#define CONFIG_OPTIONAL_TRIES 3
+static const uint8_t config_optional[] = {
+#ifdef BORDER_ROUTER_CONF_SET_CHANNEL
+  'C',
+#endif
+  'D'
+};
+static uint8_t config_answered;   /* bit i: config_optional[i] */
+static uint8_t config_seq;        /* of the last round of requests */
+static uint8_t dag_instance = RPL_DEFAULT_INSTANCE;
+static uint8_t dio_intmin, dio_intdoubl;  /* 0: RPL defaults */
+
 
 
 /* Declaration of our processes */
 
 PROCESS(border_router_process, "Border router process");
 PROCESS(coap_rest_push_server, "CoAP Rest PUSH Server");
-AUTOSTART_PROCESSES(&border_router_process, &coap_rest_push_server);
+PROCESS(temperature_sampler, "Temperature sampler");
+AUTOSTART_PROCESSES(&border_router_process, &coap_rest_push_server,
+                    &temperature_sampler);
 
 
 /////////////////////////////////////////////////
@@ -54,21 +134,98 @@ AUTOSTART_PROCESSES(&border_router_process, &coap_rest_push_server);
 
 // Note: mostly inspired by border-router-example
 
+/*
+ * RPL turns the DIO interval exponent into (1UL << exp) * CLOCK_SECOND / 1000
+ * ticks of a clock_time_t (16 bits on the Z1: at most 18)
+ */
+static int
+dio_interval_fits(int exp)
+{
+  return exp < 32 && (1UL << exp) <= ULONG_MAX / CLOCK_SECOND
+    && (1UL << exp) * CLOCK_SECOND / 1000 <= (clock_time_t)~0;
+}
+/*---------------------------------------------------------------------------*/
+/* Called by the SLIP bridge for the answers other than the prefix */
 void
-request_prefix(void)
+set_config(uint8_t key, uint8_t seq, const uint8_t *value, uint16_t len)
 {
-  /* mess up uip_buf with a dirty request... */
-  uip_buf[0] = '?';
-  uip_buf[1] = 'P';
-  uip_len = 2;
-  slip_send();
-  uip_len = 0;
+  int i;
+
+  /* the values are used when the prefix arrives, later answers are ignored */
+  if(prefix_set || seq != config_seq) {
+    return;
+  }
+
+  switch(key) {
+#ifdef BORDER_ROUTER_CONF_SET_CHANNEL
+  case 'C':
+    if(len < 1 || value[0] < 11 || value[0] > 26) {
+      return;
+    }
+    BORDER_ROUTER_CONF_SET_CHANNEL(value[0]);
+    break;
+#endif
+  case 'D':
+    /* a DODAG root needs a global instance (below 128) */
+    if(len < 3 || value[0] >= 128
+       || !dio_interval_fits(value[1] + value[2])) {
+      return;
+    }
+    dag_instance = value[0];
+    dio_intmin = value[1];
+    dio_intdoubl = value[2];
+    break;
+  default:
+    return;
+  }
+
+  for(i = 0; i < sizeof(config_optional); i++) {
+    if(config_optional[i] == key) {
+      config_answered |= 1 << i;
+    }
+  }
 }
+/*---------------------------------------------------------------------------*/
+/* Become the root of a DAG, with the parameters of the host if it gave any */
+static rpl_dag_t *
+create_dag(uip_ipaddr_t *id)
+{
+  rpl_dag_t *dag;
 
+  dag = rpl_set_root(dag_instance, id);
+  if(dag != NULL) {
+    rpl_set_prefix(dag, &prefix, 64);
+    if(dio_intmin != 0) {
+      dag->instance->dio_intmin = dio_intmin;
+      dag->instance->dio_intdoubl = dio_intdoubl;
+      rpl_reset_dio_timer(dag->instance);
+    }
+    PRINTF("created a new RPL dag\n");
+  }
+  return dag;
+}
+/*---------------------------------------------------------------------------*/
+/* Ask the keys that are still missing */
+static void
+request_config(uint8_t tries)
+{
+  int i;
+
+  config_seq++;
+  /* the optional keys first, so that they are answered before the prefix */
+  if(tries < CONFIG_OPTIONAL_TRIES) {
+    for(i = 0; i < sizeof(config_optional); i++) {
+      if(!(config_answered & (1 << i))) {
+        slip_config_request(config_optional[i], config_seq);
+      }
+    }
+  }
+  slip_config_request('P', config_seq);
+}
+/*---------------------------------------------------------------------------*/
 void
 set_prefix_64(uip_ipaddr_t *prefix_64)
 {
-  rpl_dag_t *dag;
   uip_ipaddr_t ipaddr;
   memcpy(&prefix, prefix_64, 16);
   memcpy(&ipaddr, prefix_64, 16);
@@ -76,16 +233,15 @@ set_prefix_64(uip_ipaddr_t *prefix_64)
   uip_ds6_set_addr_iid(&ipaddr, &uip_lladdr);
   uip_ds6_addr_add(&ipaddr, 0, ADDR_AUTOCONF);
 
-  dag = rpl_set_root(RPL_DEFAULT_INSTANCE, &ipaddr);
-  if(dag != NULL) {
-    rpl_set_prefix(dag, &prefix, 64);
-    PRINTF("created a new RPL dag\n");
-  }
+  create_dag(&ipaddr);
+  process_poll(&border_router_process);
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(border_router_process, ev, data)
 {
   static struct etimer et;
+  static clock_time_t interval;
+  static uint8_t tries;
 
   PROCESS_BEGIN();
 
@@ -103,12 +259,18 @@ PROCESS_THREAD(border_router_process, ev, data)
 
   PRINTF("RPL-Border router started\n");
 
-  /* Request prefix until it has been received */
-  while(!prefix_set) {
-    etimer_set(&et, CLOCK_SECOND);
-    request_prefix();
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  /* Request the configuration until the prefix has been received, the
+   * answer polls the process so that the radio is turned on right away */
+  interval = CONFIG_RETRY_MIN;
+  for(tries = 0; !prefix_set; tries++) {
+    request_config(tries);
+    etimer_set(&et, interval);
+    PROCESS_WAIT_EVENT_UNTIL(prefix_set || etimer_expired(&et));
+    if(interval < CONFIG_RETRY_MAX) {
+      interval *= 2;
+    }
   }
+  etimer_stop(&et);
 
   /* Now turn the radio on, but disable radio duty cycling.
    * Since we are the DAG root, reception delays would constrain mesh throughbut.
@@ -119,7 +281,7 @@ PROCESS_THREAD(border_router_process, ev, data)
     PROCESS_YIELD();
     if (ev == sensors_event && data == &button_sensor) {
       PRINTF("Initiating global repair\n");
-      rpl_repair_root(RPL_DEFAULT_INSTANCE);
+      rpl_repair_root(dag_instance);
     }
   }
 
@@ -150,23 +312,70 @@ PERIODIC_RESOURCE(res_temperature,
    temperature_periodic_handler);
 
 /*
- * Prepare a REST answer with temperature and time
+ * Write a centi-degree value as a decimal number ("-1.05", "21.50") without
+ * going through float formatting.
+ */
+static int
+format_centi(char *buffer, size_t size, int16_t centi)
+{
+  const char *sign = centi < 0 ? "-" : "";
+  uint16_t value = centi < 0 ? -centi : centi;
+
+  return snprintf(buffer, size, "%s%u.%02u", sign, value / 100, value % 100);
+}
+
+/*
+ * Calibrated temperature of the last sample, in centi-degrees.
+ * Calibration is applied here so that a change is visible immediately.
+ */
+static int16_t
+read_temperature(void)
+{
+  return last_sample.raw - delta_usb_temp - delta_fix_temp;
+}
+
+/*
+ * JSON representation of the last sample: temperature (0.01 degree
+ * resolution) + timestamp
+ */
+static int
+format_temperature(char *buffer, size_t size)
+{
+  char temperature[8];
+
+  format_centi(temperature, sizeof(temperature), read_temperature());
+  return snprintf(buffer, size, "{ \"temperature\":%s, \"time\":%lu }",
+                  temperature, last_sample.time);
+}
+
+/*
+ * Prepare a REST answer with temperature and time.
+ * With ?fresh the request waits for the next sample instead; the sampler
+ * takes it right away and answers every waiting request with it. Requests
+ * arriving before the first sample wait the same way.
  */
 static void
 temperature_handler(void* request, void* response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
 {
+  const char *query = NULL;
+
+  /* notifications have no request */
+  if(request != NULL
+     && (!sample_ready || (REST.get_query(request, &query) == 5
+                           && strncmp(query, "fresh", 5) == 0))) {
+    if(coap_separate_queue(&last_sample, request)) {
+      process_poll(&temperature_sampler);
+    }
+    return;
+  }
+
   /* Header: JSON + max age */
   REST.set_header_content_type(response, REST.type.APPLICATION_JSON);
   REST.set_header_max_age(response, res_temperature.periodic->period / CLOCK_SECOND);
 
-  /* Content: temparature + timestamp */
-  int8_t temparature = (int8_t) (tmp102_read_temp_x100() / 100  - DELTA_USB_TEMP - DELTA_FIX_TEMP);
-  unsigned long timestamp = clock_seconds();
-  int size = snprintf((char *)buffer, preferred_size,
-                      "{ \"temperature\":%d, \"time\":%lu }", temparature, timestamp);
-
   /* Payload */
-  REST.set_response_payload(response, buffer, size);
+  REST.set_response_payload(response, buffer,
+                            format_temperature((char *)buffer, preferred_size));
 }
 
 /*
@@ -175,7 +384,520 @@ temperature_handler(void* request, void* response, uint8_t *buffer, uint16_t pre
 static void
 temperature_periodic_handler()
 {
-  REST.notify_subscribers(&res_temperature);
+  if(sample_ready) {
+    REST.notify_subscribers(&res_temperature);
+  }
+}
+
+/*
+ * Parse a POST variable as a decimal number from min to max. The variable
+ * is not 0-terminated in the payload and must hold nothing else.
+ */
+static int
+parse_number(const char *value, int len, long min, long max, long *number)
+{
+  char str[12];
+  char *end;
+
+  if(len <= 0 || len >= sizeof(str)) {
+    return 0;
+  }
+  memcpy(str, value, len);
+  str[len] = '\0';
+  *number = strtol(str, &end, 10);
+  return end == &str[len] && *number >= min && *number <= max;
+}
+
+/*
+ * Filter resource: GET returns the oversampling settings, POST changes them,
+ * e.g. n=4&mode=median&reject=50
+ */
+static void filter_get_handler(void *request, void *response, uint8_t *buffer,
+                               uint16_t preferred_size, int32_t *offset);
+static void filter_post_handler(void *request, void *response, uint8_t *buffer,
+                                uint16_t preferred_size, int32_t *offset);
+
+RESOURCE(res_filter,
+         "title=\"Oversampling filter\";rt=\"Control\"",
+         filter_get_handler,
+         filter_post_handler,
+         NULL,
+         NULL);
+
+static void
+filter_get_handler(void *request, void *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  int size = snprintf((char *)buffer, preferred_size,
+                      "{ \"n\":%u, \"mode\":\"%s\", \"reject\":%u }",
+                      oversampling,
+                      filter_mode == FILTER_MEDIAN ? "median" : "mean",
+                      outlier_reject);
+
+  REST.set_header_content_type(response, REST.type.APPLICATION_JSON);
+  REST.set_response_payload(response, buffer, size);
+}
+
+static void
+filter_post_handler(void *request, void *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  const char *value = NULL;
+  int len;
+  long n = oversampling;
+  long reject = outlier_reject;
+  uint8_t mode = filter_mode;
+
+  /* nothing changes unless every given setting is valid */
+  if((len = REST.get_post_variable(request, "n", &value))
+     && !parse_number(value, len, 1, TEMPERATURE_MAX_OVERSAMPLING, &n)) {
+    REST.set_response_status(response, REST.status.BAD_REQUEST);
+    return;
+  }
+  if((len = REST.get_post_variable(request, "mode", &value))) {
+    if(len == 6 && strncmp(value, "median", len) == 0) {
+      mode = FILTER_MEDIAN;
+    } else if(len == 4 && strncmp(value, "mean", len) == 0) {
+      mode = FILTER_MEAN;
+    } else {
+      REST.set_response_status(response, REST.status.BAD_REQUEST);
+      return;
+    }
+  }
+  if((len = REST.get_post_variable(request, "reject", &value))
+     && !parse_number(value, len, 0, INT16_MAX, &reject)) {
+    REST.set_response_status(response, REST.status.BAD_REQUEST);
+    return;
+  }
+
+  oversampling = n;
+  filter_mode = mode;
+  outlier_reject = reject;
+
+  REST.set_response_status(response, REST.status.CHANGED);
+}
+
+/*
+ * Calibration resource: GET returns the offsets, POST changes them.
+ * Offsets are given in centi-degrees, e.g. usb=200&fix=376
+ */
+static void calibration_get_handler(void *request, void *response, uint8_t *buffer,
+                                    uint16_t preferred_size, int32_t *offset);
+static void calibration_post_handler(void *request, void *response, uint8_t *buffer,
+                                     uint16_t preferred_size, int32_t *offset);
+
+RESOURCE(res_calibration,
+         "title=\"Calibration\";rt=\"Control\"",
+         calibration_get_handler,
+         calibration_post_handler,
+         NULL,
+         NULL);
+
+static void
+calibration_get_handler(void *request, void *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  int size = snprintf((char *)buffer, preferred_size,
+                      "{ \"usb\":%d, \"fix\":%d }", delta_usb_temp, delta_fix_temp);
+
+  REST.set_header_content_type(response, REST.type.APPLICATION_JSON);
+  REST.set_response_payload(response, buffer, size);
+}
+
+static void
+calibration_post_handler(void *request, void *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  const char *value = NULL;
+  int len;
+  long usb = delta_usb_temp;
+  long fix = delta_fix_temp;
+  int changed = 0;
+
+  /* nothing changes unless every given offset is valid */
+  if((len = REST.get_post_variable(request, "usb", &value))) {
+    if(!parse_number(value, len, INT16_MIN, INT16_MAX, &usb)) {
+      REST.set_response_status(response, REST.status.BAD_REQUEST);
+      return;
+    }
+    changed = 1;
+  }
+  if((len = REST.get_post_variable(request, "fix", &value))) {
+    if(!parse_number(value, len, INT16_MIN, INT16_MAX, &fix)) {
+      REST.set_response_status(response, REST.status.BAD_REQUEST);
+      return;
+    }
+    changed = 1;
+  }
+
+  if(changed) {
+    delta_usb_temp = usb;
+    delta_fix_temp = fix;
+    /* the cached temperature was calibrated with the old offsets */
+    coap_cache_invalidate(res_temperature.url, strlen(res_temperature.url));
+    REST.set_response_status(response, REST.status.CHANGED);
+  } else {
+    REST.set_response_status(response, REST.status.BAD_REQUEST);
+  }
+}
+
+
+/*
+ * Forward proxy: off-mesh clients send GETs with a Proxy-Uri such as
+ * coap://[aaaa::212:7401:1:101]/temperature/push. Responses are kept in the
+ * engine cache under the target URI until their Max-Age runs out, so repeated
+ * requests do not cross the mesh. Requests for a target that is already being
+ * fetched wait for that fetch instead of sending their own.
+ */
+#ifndef PROXY_CONF_MAX_FETCHES
+#define PROXY_MAX_FETCHES COAP_MAX_ASYNC_REQUESTS
+#else
+#define PROXY_MAX_FETCHES PROXY_CONF_MAX_FETCHES
+#endif
+#define PROXY_MAX_URI_LEN 48
+
+struct proxy_fetch {
+  coap_async_request_t *request;  /* NULL if unused */
+  coap_cache_key_t key;           /* cache key of the first request */
+  char uri[PROXY_MAX_URI_LEN];    /* path and query, kept during the fetch */
+};
+static struct proxy_fetch fetches[PROXY_MAX_FETCHES];
+
+/*
+ * Split a "coap://[addr]:port/path?query" Proxy-Uri. Path and query are
+ * copied into `path` (PROXY_MAX_URI_LEN bytes), the query is NULL if there
+ * is none. Only motes of our mesh prefix are valid targets, so the router
+ * cannot be used to reach other hosts.
+ */
+static int
+parse_proxy_uri(const char *uri, int len, char *path,
+                uip_ipaddr_t *addr, uint16_t *port, const char **query)
+{
+  const char *end = uri + len;
+  const char *p = uri + 8;
+  const char *bracket;
+  char *q;
+
+  if(len < 8 || strncmp(uri, "coap://[", 8) != 0
+     || (bracket = memchr(p, ']', end - p)) == NULL
+     || bracket - p >= PROXY_MAX_URI_LEN) {
+    return 0;
+  }
+  memcpy(path, p, bracket - p);
+  path[bracket - p] = '\0';
+  if(!uiplib_ipaddrconv(path, addr)
+     || !prefix_set || !uip_ipaddr_prefixcmp(addr, &prefix, 64)) {
+    return 0;
+  }
+
+  p = bracket + 1;
+  *port = COAP_DEFAULT_PORT;
+  if(p < end && *p == ':') {
+    const char *digits = ++p;
+    uint32_t value = 0;
+
+    for(; p < end && isdigit((unsigned char)*p); ++p) {
+      if((value = value * 10 + *p - '0') > 0xFFFF) {
+        return 0;
+      }
+    }
+    if(p == digits || value == 0) {
+      return 0;
+    }
+    *port = value;
+  }
+  if(p < end && *p == '/') {
+    ++p;
+  }
+  if(end - p >= PROXY_MAX_URI_LEN) {
+    return 0;
+  }
+  memcpy(path, p, end - p);
+  path[end - p] = '\0';
+
+  *query = NULL;
+  if((q = strchr(path, '?')) != NULL) {
+    *q = '\0';
+    *query = q + 1;
+  }
+  return 1;
+}
+
+/*
+ * Answer the requests waiting for a fetch and keep the response in the cache.
+ * Representations larger than one block are not proxied.
+ */
+static int
+proxy_callback(coap_async_request_t *request, coap_packet_t *response,
+               coap_async_flag_t flag)
+{
+  struct proxy_fetch *fetch = (struct proxy_fetch *)request->data;
+
+  switch(flag) {
+  case COAP_ASYNC_BLOCK:
+    coap_async_cancel(request);
+    coap_separate_drain(fetch, BAD_GATEWAY_5_02, TEXT_PLAIN, "TooLarge", 8);
+    fetch->request = NULL;
+    return 1;
+  case COAP_ASYNC_DONE:
+    /* an absent Max-Age means the default of 60 seconds */
+    if(!IS_OPTION(response, COAP_OPTION_MAX_AGE)) {
+      coap_set_header_max_age(response, COAP_DEFAULT_MAX_AGE);
+    }
+    if(fetch->key.len) {
+      coap_cache_store(response, &fetch->key, 0);
+    }
+    coap_separate_forward(fetch, response);
+    break;
+  case COAP_ASYNC_TIMEOUT:
+    coap_separate_drain(fetch, GATEWAY_TIMEOUT_5_04, TEXT_PLAIN, "Timeout", 7);
+    break;
+  default:
+    coap_separate_drain(fetch, BAD_GATEWAY_5_02, TEXT_PLAIN, "SendFailed", 10);
+    break;
+  }
+  fetch->request = NULL;
+  return 0;
+}
+
+/*
+ * Observe relay: the router holds one observation per proxied target and
+ * re-publishes its notifications to all downstream observers, which are kept
+ * in the engine's observer table with the Proxy-Uri as url handle. The motes
+ * thus see a single observer whatever the number of dashboards.
+ */
+#ifndef PROXY_CONF_MAX_RELAYS
+#define PROXY_MAX_RELAYS COAP_MAX_OBSERVEES
+#else
+#define PROXY_MAX_RELAYS PROXY_CONF_MAX_RELAYS
+#endif
+
+struct proxy_relay {
+  coap_observee_t *observee;      /* NULL if unused */
+  char target[PROXY_MAX_URI_LEN]; /* Proxy-Uri, url of downstream observers */
+  char uri[PROXY_MAX_URI_LEN];    /* path observed upstream */
+  uint8_t code;                   /* 0 until the first notification */
+  int16_t content_format;         /* -1 if not set */
+  uint16_t payload_len;
+  uint8_t payload[REST_MAX_CHUNK_SIZE];
+};
+static struct proxy_relay relays[PROXY_MAX_RELAYS];
+
+static int
+relay_observers(struct proxy_relay *relay)
+{
+  coap_observer_t *obs;
+  int count = 0;
+
+  for(obs = (coap_observer_t *)list_head(coap_get_observers()); obs;
+      obs = obs->next) {
+    if(obs->url == relay->target) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/*
+ * Free a relay and drop its downstream observers. The upstream observation
+ * is forgotten; the mote gets a RST with its next notification.
+ */
+static void
+relay_release(struct proxy_relay *relay)
+{
+  coap_observer_t *obs;
+  coap_observer_t *next;
+
+  BINLOG_DEBUG(BINLOG1(EV_PROXY_RELEASE, relay - relays));
+  for(obs = (coap_observer_t *)list_head(coap_get_observers()); obs;
+      obs = next) {
+    next = obs->next;
+    if(obs->url == relay->target) {
+      coap_remove_observer(obs);
+    }
+  }
+  if(relay->observee) {
+    coap_obs_remove_observee(relay->observee);
+  }
+  relay->observee = NULL;
+}
+
+static void
+relay_callback(coap_observee_t *subject, void *notification,
+               coap_notification_flag_t flag)
+{
+  struct proxy_relay *relay = (struct proxy_relay *)subject->data;
+  coap_packet_t *packet = (coap_packet_t *)notification;
+  coap_packet_t error[1];
+
+  if(flag == OBSERVE_OK || flag == NOTIFICATION_OK) {
+    /* kept for the initial response to later registrations */
+    relay->code = packet->code;
+    relay->content_format = IS_OPTION(packet, COAP_OPTION_CONTENT_FORMAT)
+      ? (int16_t)packet->content_format : -1;
+    relay->payload_len = MIN(packet->payload_len, REST_MAX_CHUNK_SIZE);
+    memcpy(relay->payload, packet->payload, relay->payload_len);
+
+    if(relay_observers(relay) == 0) {
+      relay_release(relay);
+    } else {
+      coap_notify_observers_of(relay->target, packet);
+    }
+    return;
+  }
+
+  /* the observation ended upstream: an error code ends it downstream too */
+  if(flag != ERROR_RESPONSE_CODE) {
+    coap_init_message(error, COAP_TYPE_NON,
+                      packet ? BAD_GATEWAY_5_02 : GATEWAY_TIMEOUT_5_04, 0);
+    packet = error;
+  }
+  coap_notify_observers_of(relay->target, packet);
+
+  /* a failed registration is removed by the observe client */
+  if(relay->code == 0) {
+    relay->observee = NULL;
+  }
+  relay_release(relay);
+}
+
+/*
+ * Register (Observe: 0) or deregister (Observe: 1) a downstream observer.
+ * Returns 0 to proxy the request as a plain GET instead.
+ */
+static int
+proxy_observe(coap_packet_t *request, coap_packet_t *response,
+              const char *uri, int len)
+{
+  coap_request_context_t *const ctx = coap_get_request_context();
+  struct proxy_relay *relay = NULL;
+  struct proxy_relay *free_relay = NULL;
+  coap_observer_t *obs;
+  const char *query = NULL;
+  uip_ipaddr_t addr;
+  uint16_t port;
+  int i;
+
+  if(len >= PROXY_MAX_URI_LEN) {
+    return 0;
+  }
+  for(i = 0; i < PROXY_MAX_RELAYS; i++) {
+    if(relays[i].observee == NULL) {
+      free_relay = free_relay ? free_relay : &relays[i];
+    } else if(strlen(relays[i].target) == (size_t)len
+              && strncmp(relays[i].target, uri, len) == 0) {
+      relay = &relays[i];
+    }
+  }
+
+  if(request->observe == 1) {
+    if(relay) {
+      coap_remove_observer_by_token(&ctx->addr, ctx->port,
+                                    request->token, request->token_len);
+      /* a pending registration is released by its first notification */
+      if(relay->code && relay_observers(relay) == 0) {
+        relay_release(relay);
+      }
+    }
+    return 0;
+  }
+
+  if(relay == NULL) {
+    /* the observe client only supports a path */
+    if(free_relay == NULL
+       || !parse_proxy_uri(uri, len, free_relay->uri, &addr, &port, &query)
+       || query != NULL) {
+      return 0;
+    }
+    relay = free_relay;
+    memcpy(relay->target, uri, len);
+    relay->target[len] = '\0';
+    relay->code = 0;
+    relay->observee = coap_obs_request_registration(&addr, UIP_HTONS(port),
+                                                    relay->uri,
+                                                    relay_callback, relay);
+    if(relay->observee == NULL) {
+      return 0;
+    }
+    BINLOG_DEBUG(BINLOG1(EV_PROXY_RELAY, relay - relays));
+  }
+
+  obs = coap_add_observer(&ctx->addr, ctx->port, request->token,
+                          request->token_len, relay->target);
+  if(obs == NULL) {
+    coap_set_status_code(response, SERVICE_UNAVAILABLE_5_03);
+    coap_set_payload(response, "TooManyObservers", 16);
+  } else if(relay->code) {
+    coap_set_status_code(response, relay->code);
+    if(relay->content_format >= 0) {
+      coap_set_header_content_format(response, relay->content_format);
+    }
+    coap_set_header_observe(response, (obs->obs_counter)++);
+    coap_set_payload(response, relay->payload, relay->payload_len);
+  } else {
+    /* the first notification from upstream answers the registration */
+    coap_separate_ack(request);
+  }
+  return 1;
+}
+
+/*
+ * Called by the engine for requests with Proxy-Uri that are not in the cache.
+ */
+static int
+proxy_handler(void *request, void *response, uint8_t *buffer,
+              uint16_t preferred_size, int32_t *offset)
+{
+  struct proxy_fetch *fetch = NULL;
+  const char *uri = NULL;
+  const char *query = NULL;
+  uip_ipaddr_t addr;
+  uint16_t port;
+  coap_cache_key_t key;
+  int len;
+  int i;
+
+  /* Proxy-Scheme with Uri-Host is not supported */
+  if((len = coap_get_header_proxy_uri(request, &uri)) == 0) {
+    return 0;
+  }
+  if(((coap_packet_t *)request)->code != COAP_GET) {
+    coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
+    return 1;
+  }
+  if(IS_OPTION((coap_packet_t *)request, COAP_OPTION_OBSERVE)
+     && proxy_observe(request, response, uri, len)) {
+    return 1;
+  }
+
+  /* join a fetch of the same target (none for Observe/Block2, not shared) */
+  coap_cache_key(request, &key);
+  for(i = 0; i < PROXY_MAX_FETCHES; i++) {
+    if(fetches[i].request == NULL) {
+      fetch = fetch ? fetch : &fetches[i];
+    } else if(key.len && coap_cache_key_equal(&fetches[i].key, &key)) {
+      BINLOG_DEBUG(BINLOG1(EV_PROXY_JOIN, i));
+      coap_separate_queue(&fetches[i], request);
+      return 1;
+    }
+  }
+  if(fetch == NULL) {
+    coap_separate_reject();
+    return 1;
+  }
+
+  if(!parse_proxy_uri(uri, len, fetch->uri, &addr, &port, &query)) {
+    coap_set_status_code(response, PROXYING_NOT_SUPPORTED_5_05);
+    return 1;
+  }
+
+  memcpy(&fetch->key, &key, sizeof(key));
+  fetch->request = coap_async_request(&addr, UIP_HTONS(port), COAP_GET,
+                                      fetch->uri, query, NULL, 0,
+                                      proxy_callback, fetch);
+  if(fetch->request == NULL) {
+    coap_separate_reject();
+  } else if(!coap_separate_queue(fetch, request)) {
+    coap_async_cancel(fetch->request);
+    fetch->request = NULL;
+  }
+  return 1;
 }
 
 
@@ -185,14 +907,107 @@ PROCESS_THREAD(coap_rest_push_server, ev, data)
 
   PRINTF("COAP REST Push Server\n");
 
-  /* Initialize temperature sensor. */
-  tmp102_init();
+  binlog_init();
 
   /* Initialize our REST engine. */
   rest_init_engine();
 
-  /* Activate resources: just temperature */
+  /* Activate resources: temperature, its calibration and filter */
   rest_activate_resource(&res_temperature, "temperature/push");
+  rest_activate_resource(&res_calibration, "temperature/calibration");
+  rest_activate_resource(&res_filter, "temperature/filter");
+
+  /* Off-mesh clients can reach the motes through the proxy */
+  coap_set_proxy_callback(proxy_handler);
+
+  PROCESS_END();
+}
+
+/*
+ * Reduce `count` reads to one value according to the filter settings.
+ * Sorts `reads` in place.
+ */
+static int16_t
+decimate(int16_t *reads, uint8_t count)
+{
+  uint8_t i, j;
+  int16_t tmp;
+  int16_t median;
+  int32_t sum = 0;
+  uint8_t kept = 0;
+
+  /* insertion sort, count is small */
+  for(i = 1; i < count; i++) {
+    tmp = reads[i];
+    for(j = i; j > 0 && reads[j - 1] > tmp; j--) {
+      reads[j] = reads[j - 1];
+    }
+    reads[j] = tmp;
+  }
+
+  if(count & 1) {
+    median = reads[count / 2];
+  } else {
+    median = (reads[count / 2 - 1] + reads[count / 2]) / 2;
+  }
+  if(filter_mode == FILTER_MEDIAN) {
+    return median;
+  }
+
+  for(i = 0; i < count; i++) {
+    if(outlier_reject == 0 || abs(reads[i] - median) <= outlier_reject) {
+      sum += reads[i];
+      kept++;
+    }
+  }
+  /* every read rejected: only possible with an even count */
+  if(kept == 0) {
+    return median;
+  }
+  BINLOG_DEBUG(BINLOG2(EV_DECIMATED, kept, count));
+  return sum / kept;
+}
+
+/*
+ * Read the sensor `oversampling` times per period and decimate the reads
+ * into last_sample. Requests waiting for a fresh sample close the window
+ * early and all share the resulting sample.
+ */
+PROCESS_THREAD(temperature_sampler, ev, data)
+{
+  static struct etimer sample_timer;
+  static int16_t reads[TEMPERATURE_MAX_OVERSAMPLING];
+  static uint8_t count;
+  static char fresh[48];
+
+  PROCESS_BEGIN();
+
+  /* Initialize temperature sensor. */
+  tmp102_init();
+  count = 0;
+
+  while(1) {
+    reads[count++] = tmp102_read_temp_x100();
+
+    /* oversampling may have been lowered while filling the window */
+    if(count >= oversampling || coap_separate_waiting(&last_sample)) {
+      last_sample.raw = decimate(reads, count);
+      last_sample.time = clock_seconds();
+      sample_ready = 1;
+      BINLOG_DEBUG(BINLOG2(EV_SAMPLE, last_sample.raw, last_sample.time));
+      count = 0;
+
+      if(coap_separate_waiting(&last_sample)) {
+        coap_separate_drain(&last_sample, CONTENT_2_05,
+                            APPLICATION_JSON, fresh,
+                            format_temperature(fresh, sizeof(fresh)));
+      }
+    }
+
+    etimer_set(&sample_timer, TEMPERATURE_SAMPLE_PERIOD / oversampling);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&sample_timer)
+                             || ev == PROCESS_EVENT_POLL);
+  }
 
   PROCESS_END();
 }
@@ -55,9 +55,10 @@
 #endif
 
 
-/* Multiplies with chunk size, be aware of memory constraints. */
+/* Multiplies with chunk size, be aware of memory constraints.
+ * One per observer (CON notifications) plus one for requests. */
 #undef COAP_MAX_OPEN_TRANSACTIONS
-#define COAP_MAX_OPEN_TRANSACTIONS     4
+#define COAP_MAX_OPEN_TRANSACTIONS     7
 
  /* Increase rpl-border-router IP-buffer when using more than 64. */
 #undef REST_MAX_CHUNK_SIZE
@@ -66,7 +67,45 @@
 /* Filtering .well-known/core per query can be disabled to save space. */
 #undef COAP_LINK_FORMAT_FILTERING
 #define COAP_LINK_FORMAT_FILTERING     0
+
+/* Act as a caching forward proxy for the motes (needs the async client). */
 #undef COAP_PROXY_OPTION_PROCESSING
-#define COAP_PROXY_OPTION_PROCESSING   0
+#define COAP_PROXY_OPTION_PROCESSING   1
+#undef COAP_ASYNC_CLIENT
+#define COAP_ASYNC_CLIENT              1
+#undef COAP_MAX_SEPARATE_WAITERS
+#define COAP_MAX_SEPARATE_WAITERS      4
+
+/* Relay observations of the motes: one upstream, many downstream observers. */
+#undef COAP_OBSERVE_CLIENT
+#define COAP_OBSERVE_CLIENT            1
+#undef COAP_CONF_MAX_OBSERVEES
+#define COAP_CONF_MAX_OBSERVEES        2
+#undef COAP_MAX_OBSERVERS
+#define COAP_MAX_OBSERVERS             6
+
+/* Reassemble Block1 uploads (calibration/configuration) in the engine. */
+#undef COAP_BLOCK1_REASSEMBLY
+#define COAP_BLOCK1_REASSEMBLY         1
+#undef COAP_BLOCK1_MAX_BUFFERS
+#define COAP_BLOCK1_MAX_BUFFERS        1
+#undef COAP_BLOCK1_MAX_BODY_SIZE
+#define COAP_BLOCK1_MAX_BODY_SIZE      192
+
+/* Answer repeated GETs of resources with a Max-Age from the engine cache. */
+#undef COAP_CACHE
+#define COAP_CACHE                     1
+#undef COAP_CACHE_ENTRIES
+#define COAP_CACHE_ENTRIES             3
+#undef COAP_CACHE_MAX_KEY
+#define COAP_CACHE_MAX_KEY             64
+
+/* SLIP frames fill the UART0 transmit ring, drained by the TX interrupt. */
+#undef UART0_CONF_TX_WITH_INTERRUPT
+#define UART0_CONF_TX_WITH_INTERRUPT   1
+
+/* The host may set the channel of the CC2420 of the Z1 (?C). */
+#undef BORDER_ROUTER_CONF_SET_CHANNEL
+#define BORDER_ROUTER_CONF_SET_CHANNEL cc2420_set_channel
 
 #endif /* PROJECT_ROUTER_CONF_H_ */
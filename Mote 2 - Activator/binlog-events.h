@@ -0,0 +1,22 @@
+/*
+ * Binary log events of the fan activator. The comment of each event is
+ * the format tools/binlog-decode.py prints its arguments with. EV_FAN is
+ * a debug event (BINLOG_LEVEL_DEBUG).
+ */
+
+#ifndef BINLOG_EVENTS_H_
+#define BINLOG_EVENTS_H_
+
+#include "binlog.h"
+
+#define EV_NOTIFICATION       1  /* source %d: temperature %d (x100), time %d */
+#define EV_NOTIFICATION_EMPTY 2  /* source %d: notification without temperature */
+#define EV_OBSERVE_OK         3  /* source %d: observation accepted */
+#define EV_OBSERVE_REFUSED    4  /* source %d: observation not supported */
+#define EV_OBSERVE_ERROR      5  /* source %d: error response %d */
+#define EV_OBSERVE_NO_REPLY   6  /* source %d: no reply, token %04x */
+#define EV_OBSERVE_START      7  /* source %d: starting observation */
+#define EV_OBSERVE_STOP       8  /* source %d: stopping observation */
+#define EV_FAN                9  /* fan %d Hz, delta %d, threshold %d, mean %d (x100), rssi %d */
+
+#endif /* BINLOG_EVENTS_H_ */
@@ -4,13 +4,16 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <string.h>
 #include "contiki.h"
 #include "contiki-net.h"
+#include "net/uiplib.h" // for parsing source addresses
 #include "rest-engine.h" // for coap server
 #include "er-coap-engine.h" // for coap observe client
 #include "dev/cc2420.h" // for radio sensor
 #include "dev/cc2420_const.h"
+#include "binlog-events.h" // diagnostics without printf
 
 /*
 * Include Sensors
@@ -37,16 +40,38 @@
 #define REMOTE_PORT     UIP_HTONS(COAP_DEFAULT_PORT)
 #define HISTORY 4
 #define DEFAULT_THRESHOLD 20.0f
+#define MAX_THRESHOLD 125 // highest temperature of the sensor, in degrees
+
+/*
+ * Observed temperature servers. Sources are added and removed at runtime
+ * through the "sources" resource, SERVER_NODE is observed at boot.
+ */
+#define MAX_SOURCES COAP_MAX_OBSERVEES
+#define SOURCE_STALE_TIME 60 // seconds without notification before a source is ignored
+#define SOURCE_CHECK_PERIOD (30 * CLOCK_SECOND) // retry failed/stale observations
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
 
 // We want to keep temperature and time
 struct temp_record {
-    int temperature;
+    int temperature; // centi-degrees
     unsigned long time; // we will not use time but it is useful when debugging + stats
 };
-static struct temp_record temperature[HISTORY];
-static int temp_pos;
 
-static int rssi; // Last RSSI value
+struct source {
+  uint8_t used;
+  uint8_t registered; // server accepted the observation
+  uip_ipaddr_t addr;
+  coap_observee_t *obs;
+  struct temp_record history[HISTORY];
+  int pos;
+  int rssi; // RSSI of the last notification from this source
+  unsigned long last_seen; // clock_seconds() of the last notification
+};
+static struct source sources[MAX_SOURCES];
+
 static int threshold; // can be modified
 static int fan_frequency = 1; // check each seconds
 static struct etimer activator_timer; // timer for the fan
@@ -72,75 +97,248 @@ AUTOSTART_PROCESSES(&er_observe_client, &rest_server, &activator);
  * Store last RSSI value from radio sensor
  */
 static void
-do_rssi(void)
+do_rssi(struct source *src)
 {
-  rssi = radio_sensor.value(RADIO_SENSOR_LAST_VALUE) + 55;
-  PRINTF("RSSI:%d\n ", rssi);
+  src->rssi = radio_sensor.value(RADIO_SENSOR_LAST_VALUE) + 55;
+  PRINTF("RSSI:%d\n ", src->rssi);
 }
 
 /*
- * Parse `json` string and put temperature and timestamp into `record` structure
+ * Minimal JSON tokenizer for the notifications we receive, something like
+ * { "temperature":21.53, "time":2412 }. SenML short names "v" and "t" are
+ * accepted too, keys can come in any order and unknown keys are skipped.
+ * It reads at most `len` bytes and never writes into the payload, so it
+ * does not rely on the CoAP parser having terminated it.
  * No need to use Contiki JSON parser just for that.
- * Return -1 if error.
  */
+#define RECORD_HAS_TEMPERATURE 0x01
+#define RECORD_HAS_TIME        0x02
+
+static const uint8_t *
+skip_spaces(const uint8_t *p, const uint8_t *end)
+{
+  while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+    p++;
+  return p;
+}
+
+/*
+ * Parse a decimal number into hundredths, e.g. "-1.5" gives -150.
+ * Extra decimals are truncated and large values saturate.
+ * Return NULL if there is no number.
+ */
+#define CENTI_MAX (LONG_MAX / 100 - 1)
+
+static const uint8_t *
+parse_centi(const uint8_t *p, const uint8_t *end, long *value)
+{
+  int negative = 0;
+  int decimals = 0;
+  const uint8_t *digits;
+  long v = 0;
+
+  if(p < end && *p == '-') {
+    negative = 1;
+    p++;
+  }
+  digits = p;
+  while(p < end && *p >= '0' && *p <= '9') {
+    v = v > (CENTI_MAX - 9) / 10 ? CENTI_MAX : v * 10 + (*p - '0');
+    p++;
+  }
+  if(p == digits)
+    return NULL;
+  v *= 100;
+  if(p < end && *p == '.') {
+    p++;
+    while(p < end && *p >= '0' && *p <= '9') {
+      if(decimals < 2)
+        v += (*p - '0') * (decimals == 0 ? 10 : 1);
+      decimals++;
+      p++;
+    }
+  }
+  *value = negative ? -v : v;
+  return p;
+}
+
+/*
+ * Parse the integer part of a number, e.g. "2412" or "2412.7" gives 2412.
+ * Large values saturate. Return NULL if there is no number.
+ */
+static const uint8_t *
+parse_long(const uint8_t *p, const uint8_t *end, long *value)
+{
+  int negative = 0;
+  const uint8_t *digits;
+  long v = 0;
+
+  if(p < end && *p == '-') {
+    negative = 1;
+    p++;
+  }
+  digits = p;
+  while(p < end && *p >= '0' && *p <= '9') {
+    v = v > (LONG_MAX - 9) / 10 ? LONG_MAX : v * 10 + (*p - '0');
+    p++;
+  }
+  if(p == digits)
+    return NULL;
+  if(p < end && *p == '.') {
+    p++;
+    while(p < end && *p >= '0' && *p <= '9')
+      p++;
+  }
+  *value = negative ? -v : v;
+  return p;
+}
+
 static int
-get_temperature_and_time(char * json, struct temp_record *record)
+key_is(const uint8_t *key, size_t key_len, const char *name)
 {
-  // We will receive something like: { "temperature":21, "time":2412 }
-
-  // Find the first ':'  and point to the next char
-  char *start = strchr(json, ':') + 1;
-  if (start == NULL) goto error;
-  //find the ',' that marks the end of the temp and replace it by \0
-  char *end = strchr(start, ',');
-  if (start == NULL) goto error;
-  *end = '\0';
-  record->temperature = atoi(start); // convert it to int
-
-  // Find the first ':' for 'time' and point to the next char
-  start = strchr(end + 1, ':') + 1;
-  if (start == NULL) goto error;
-  end = strchr(start, ' '); // End with space
-  if (start == NULL) goto error;
-  *end = '\0';
-  record->time = atol(start); // convert it to long
-  return 0;
+  return key_len == strlen(name) && memcmp(key, name, key_len) == 0;
+}
+
+/*
+ * Parse `payload` and put temperature (centi-degrees) and timestamp into
+ * `record` structure.
+ * Return the RECORD_HAS_* fields found, -1 if error.
+ */
+static int
+parse_temp_record(const uint8_t *payload, int len, struct temp_record *record)
+{
+  const uint8_t *p = payload;
+  const uint8_t *end = payload + len;
+  const uint8_t *key;
+  size_t key_len;
+  long value;
+  int found = 0;
+
+  record->temperature = 0;
+  record->time = 0;
+
+  p = skip_spaces(p, end);
+  if(p == end || *p++ != '{') goto error;
+
+  while(1) {
+    p = skip_spaces(p, end);
+    if(p == end) goto error;
+    if(*p == '}') break;
+
+    /* "key" */
+    if(*p++ != '"') goto error;
+    key = p;
+    while(p < end && *p != '"' && *p != '\\')
+      p++;
+    if(p == end || *p != '"') goto error;
+    key_len = p - key;
+    p = skip_spaces(p + 1, end);
+    if(p == end || *p++ != ':') goto error;
+    p = skip_spaces(p, end);
+    if(p == end) goto error;
+
+    /* value */
+    if(*p == '-' || (*p >= '0' && *p <= '9')) {
+      if(key_is(key, key_len, "temperature") || key_is(key, key_len, "v")) {
+        if((p = parse_centi(p, end, &value)) == NULL) goto error;
+        record->temperature = value > INT_MAX ? INT_MAX
+                            : value < INT_MIN ? INT_MIN : value;
+        found |= RECORD_HAS_TEMPERATURE;
+      } else {
+        if((p = parse_long(p, end, &value)) == NULL) goto error;
+        if(key_is(key, key_len, "time") || key_is(key, key_len, "t")) {
+          record->time = value < 0 ? 0 : value;
+          found |= RECORD_HAS_TIME;
+        }
+      }
+    } else if(*p == '"') {
+      /* skip string values (e.g. SenML "n") */
+      p++;
+      while(p < end && *p != '"' && *p != '\\')
+        p++;
+      if(p == end || *p++ != '"') goto error;
+    } else if(*p >= 'a' && *p <= 'z') {
+      /* true, false, null */
+      while(p < end && *p >= 'a' && *p <= 'z')
+        p++;
+    } else {
+      goto error;
+    }
+
+    p = skip_spaces(p, end);
+    if(p == end) goto error;
+    if(*p == '}') break;
+    if(*p++ != ',') goto error;
+  }
+  return found;
 
 error:
-  PRINTF("Error when parsing JSON: %s", json);
+  PRINTF("Error when parsing JSON at byte %d: %.*s\n", (int)(p - payload), len, payload);
   record->temperature = 0;
   record->time = 0;
   return -1;
 }
 
 /*
- * Compute the mean temperature from all stored values
+ * Compute the mean temperature from all stored values of a source
  */
 static int
-mean(void)
+mean(struct source *src)
 {
   int i;
-  int mean = 0;
+  long mean = 0;
   for(i = 0; i < HISTORY; i++)
-    mean += temperature[i].temperature;
+    mean += src->history[i].temperature;
 
-  // if not enough info, use temp_pos
-  if (temp_pos < HISTORY)
-    return mean / temp_pos;
+  // if not enough info, use pos
+  if (src->pos < HISTORY)
+    return mean / src->pos;
   else
     return mean / HISTORY;
 }
 
+/*
+ * Aggregate all fresh sources into one temperature and RSSI, each source
+ * weighted by its freshness (a source seen just now counts SOURCE_STALE_TIME
+ * times more than one about to become stale).
+ * Return the number of sources used, 0 if no data is available.
+ */
+static int
+aggregate(int *temperature, int *rssi)
+{
+  int i;
+  int used = 0;
+  long weight;
+  long total_weight = 0;
+  long temp_sum = 0;
+  long rssi_sum = 0;
+  unsigned long now = clock_seconds();
+
+  for(i = 0; i < MAX_SOURCES; i++) {
+    if(!sources[i].used || sources[i].pos == 0
+       || now - sources[i].last_seen >= SOURCE_STALE_TIME) {
+      continue;
+    }
+    weight = SOURCE_STALE_TIME - (now - sources[i].last_seen);
+    temp_sum += weight * mean(&sources[i]);
+    rssi_sum += weight * sources[i].rssi;
+    total_weight += weight;
+    used++;
+  }
+
+  if(used) {
+    *temperature = temp_sum / total_weight;
+    *rssi = rssi_sum / total_weight;
+  }
+  return used;
+}
+
 /*----------------------------------------------------------------------------*/
 /*
  * CoAP Observe Client
  */
 /*----------------------------------------------------------------------------*/
 
-static uip_ipaddr_t server_ipaddr[1]; // holds the server ip address
-static coap_observee_t *obs;
-
-
 #define OBS_RESOURCE_URI "temperature/push" // resource to observate
 
 /*
@@ -152,82 +350,175 @@ notification_callback(coap_observee_t *obs, void *notification,
 {
   int len = 0;
   const uint8_t *payload = NULL;
+  struct source *src = (struct source *)obs->data;
 
-  printf("Notification handler\n");
-  printf("Observee URI: %s\n", obs->url);
   if(notification) {
     len = coap_get_payload(notification, &payload);
   }
   switch(flag) {
   case NOTIFICATION_OK:
-    printf("NOTIFICATION OK: %*s\n", len, (char *)payload);
-    do_rssi(); // record last RSSI value
-    struct temp_record * record = &temperature[(temp_pos++)%HISTORY];
-    get_temperature_and_time((char *)payload, record);
-    printf("Readed Temp: %d, Readed Time %lu\n", record->temperature, record->time);
-    break;
+    do_rssi(src); // record last RSSI value
+    struct temp_record record;
+    int found = parse_temp_record(payload, len, &record);
+    if(found < 0 || !(found & RECORD_HAS_TEMPERATURE)) {
+      BINLOG1(EV_NOTIFICATION_EMPTY, src - sources);
+      return;
+    }
+    src->history[(src->pos++)%HISTORY] = record;
+    src->last_seen = clock_seconds();
+    BINLOG3(EV_NOTIFICATION, src - sources, record.temperature, record.time);
+    return;
 
   case OBSERVE_OK: /* server accepeted observation request */
-    printf("OBSERVE_OK: %*s\n", len, (char *)payload);
-    break;
+    BINLOG1(EV_OBSERVE_OK, src - sources);
+    src->registered = 1;
+    src->last_seen = clock_seconds();
+    return;
 
   case OBSERVE_NOT_SUPPORTED:
-    printf("OBSERVE_NOT_SUPPORTED: %*s\n", len, (char *)payload);
-    obs = NULL;
+    BINLOG1(EV_OBSERVE_REFUSED, src - sources);
     break;
 
   case ERROR_RESPONSE_CODE:
-    printf("ERROR_RESPONSE_CODE: %*s\n", len, (char *)payload);
-    obs = NULL;
+    BINLOG2(EV_OBSERVE_ERROR, src - sources,
+            notification ? ((coap_packet_t *)notification)->code : 0);
     break;
 
   case NO_REPLY_FROM_SERVER:
-    printf("NO_REPLY_FROM_SERVER: "
-           "removing observe registration with token %x%x\n",
-           obs->token[0], obs->token[1]);
-    obs = NULL;
+    BINLOG2(EV_OBSERVE_NO_REPLY, src - sources,
+            (obs->token[0] << 8) | obs->token[1]);
     break;
   }
+
+  /*
+   * The observation is over. Failed registrations are freed by the observe
+   * client itself, established ones must be removed here.
+   */
+  if(src->registered) {
+    coap_obs_remove_observee(obs);
+  }
+  src->obs = NULL;
+  src->registered = 0;
 }
 
 /*
- * Toggle the observation of the remote resource
+ * Start the observation of the remote resource on a source
  */
-void
-toggle_observation(void)
+static void
+start_observation(struct source *src)
 {
-  if (obs) {
-    printf("Stopping observation\n");
-    coap_obs_remove_observee(obs);
-    obs = NULL;
+  BINLOG1(EV_OBSERVE_START, src - sources);
+  src->registered = 0;
+  src->obs = coap_obs_request_registration(&src->addr, REMOTE_PORT,
+                                           OBS_RESOURCE_URI,
+                                           notification_callback, src);
+}
+
+/*
+ * Stop the observation of the remote resource on a source
+ */
+static void
+stop_observation(struct source *src)
+{
+  if(src->obs) {
+    BINLOG1(EV_OBSERVE_STOP, src - sources);
+    coap_obs_remove_observee(src->obs);
+    src->obs = NULL;
   }
-  else {
-    printf("Starting observation\n");
-    obs = coap_obs_request_registration(server_ipaddr, REMOTE_PORT,
-                                        OBS_RESOURCE_URI, notification_callback,
-                                        NULL);
+  src->registered = 0;
+}
+
+static struct source *
+find_source(uip_ipaddr_t *addr)
+{
+  int i;
+  for(i = 0; i < MAX_SOURCES; i++) {
+    if(sources[i].used && uip_ipaddr_cmp(&sources[i].addr, addr)) {
+      return &sources[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Add a source and start observing it. Return NULL if the table is full.
+ */
+static struct source *
+add_source(uip_ipaddr_t *addr)
+{
+  int i;
+  struct source *src = find_source(addr);
+
+  if(src) {
+    return src;
+  }
+  for(i = 0; i < MAX_SOURCES; i++) {
+    if(!sources[i].used) {
+      src = &sources[i];
+      memset(src, 0, sizeof(struct source));
+      uip_ipaddr_copy(&src->addr, addr);
+      src->used = 1;
+      start_observation(src);
+      return src;
+    }
+  }
+  return NULL;
+}
+
+static void
+remove_source(struct source *src)
+{
+  stop_observation(src);
+  src->used = 0;
+}
+
+/*
+ * Restart observations that failed or went silent (e.g. server reboot)
+ */
+static void
+check_sources(void)
+{
+  int i;
+  for(i = 0; i < MAX_SOURCES; i++) {
+    if(!sources[i].used) {
+      continue;
+    }
+    if(sources[i].registered
+       && clock_seconds() - sources[i].last_seen >= SOURCE_STALE_TIME) {
+      stop_observation(&sources[i]);
+    }
+    if(sources[i].obs == NULL) {
+      start_observation(&sources[i]);
+    }
   }
 }
 
 /*----------------------------------------------------------------------------*/
 /*
  * The observer thread. It starts the observation of the remote
- * resource (temperature)
+ * resource (temperature) and keeps the observations alive
  */
 PROCESS_THREAD(er_observe_client, ev, data)
 {
+  static struct etimer check_timer;
+  uip_ipaddr_t server_ipaddr;
+
   PROCESS_BEGIN();
 
-  /* store server address in server_ipaddr */
-  SERVER_NODE(server_ipaddr);
   /* receives all CoAP responses */
   coap_init_engine();
-  temp_pos = 0;
 
-  toggle_observation();
+  /* observe the default server */
+  SERVER_NODE(&server_ipaddr);
+  add_source(&server_ipaddr);
 
+  etimer_set(&check_timer, SOURCE_CHECK_PERIOD);
   while(1) {
     PROCESS_YIELD();
+    if(etimer_expired(&check_timer)) {
+      check_sources();
+      etimer_reset(&check_timer);
+    }
   }
   PROCESS_END();
 }
@@ -253,10 +544,154 @@ res_post_handler(void *request, void *response, uint8_t *buffer, uint16_t prefer
 {
   size_t len = 0;
   const char *tresh = NULL;
+  char str[8];
+  long value;
   if ((len = REST.get_post_variable(request, "threshold", &tresh))) {
-    threshold = atoi(tresh);
-    if (threshold <= 0)
-      threshold = DEFAULT_THRESHOLD;
+    /* the variable is not 0-terminated in the payload */
+    if (len >= sizeof(str)) {
+      REST.set_response_status(response, REST.status.BAD_REQUEST);
+      return;
+    }
+    memcpy(str, tresh, len);
+    str[len] = '\0';
+    value = strtol(str, NULL, 10);
+    if (value > MAX_THRESHOLD) {
+      REST.set_response_status(response, REST.status.BAD_REQUEST);
+      return;
+    }
+    threshold = value <= 0 ? DEFAULT_THRESHOLD : value;
+  }
+}
+
+/*
+ * Sources resource: GET lists the observed servers, one per line with the
+ * age in seconds of their last notification. POST add=<ipv6> or
+ * remove=<ipv6> changes the set.
+ */
+static void sources_get_handler(void *request, void *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void sources_post_handler(void *request, void *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+
+RESOURCE(res_sources,
+         "title=\"Temperature sources\";rt=\"Control\"",
+         sources_get_handler,
+         sources_post_handler,
+         NULL,
+         NULL);
+
+/*
+ * Write an IPv6 address in its compressed text form, return its length
+ */
+static int
+format_ipaddr(char *buf, const uip_ipaddr_t *addr)
+{
+  uint16_t a;
+  int i, f;
+  int len = 0;
+  for(i = 0, f = 0; i < sizeof(uip_ipaddr_t); i += 2) {
+    a = (addr->u8[i] << 8) + addr->u8[i + 1];
+    if(a == 0 && f >= 0) {
+      if(f++ == 0) {
+        buf[len++] = ':';
+        buf[len++] = ':';
+      }
+    } else {
+      if(f > 0) {
+        f = -1;
+      } else if(i > 0) {
+        buf[len++] = ':';
+      }
+      len += sprintf(&buf[len], "%x", a);
+    }
+  }
+  buf[len] = '\0';
+  return len;
+}
+
+static void
+sources_get_handler(void *request, void *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  char line[56];
+  int i, len;
+  int32_t strpos = 0; // position in the whole listing
+  int32_t start, end;
+
+  /* Blockwise: only copy the part of each line that falls into this block */
+  for(i = 0; i < MAX_SOURCES; i++) {
+    if(!sources[i].used) {
+      continue;
+    }
+    len = format_ipaddr(line, &sources[i].addr);
+    if(sources[i].registered) {
+      len += snprintf(&line[len], sizeof(line) - len, " %lus\n",
+                      clock_seconds() - sources[i].last_seen);
+    } else {
+      len += snprintf(&line[len], sizeof(line) - len, " -\n");
+    }
+
+    start = MAX(strpos, *offset);
+    end = MIN(strpos + len, *offset + preferred_size);
+    if(start < end) {
+      memcpy(buffer + start - *offset, line + start - strpos, end - start);
+    }
+    strpos += len;
+  }
+
+  if(strpos > 0 && strpos <= *offset) {
+    REST.set_response_status(response, REST.status.BAD_OPTION);
+    REST.set_response_payload(response, "BlockOutOfScope", 15);
+    return;
+  }
+
+  REST.set_header_content_type(response, REST.type.TEXT_PLAIN);
+  REST.set_response_payload(response, buffer,
+                            MIN(strpos - *offset, preferred_size));
+  if(strpos <= *offset + preferred_size) {
+    *offset = -1;
+  } else {
+    *offset += preferred_size;
+  }
+}
+
+static void
+sources_post_handler(void *request, void *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+  char addrstr[40];
+  uip_ipaddr_t addr;
+  const char *value = NULL;
+  struct source *src;
+  int len;
+  int add = 1;
+
+  if(!(len = REST.get_post_variable(request, "add", &value))) {
+    len = REST.get_post_variable(request, "remove", &value);
+    add = 0;
+  }
+  /* the variable is not 0-terminated in the payload */
+  if(len <= 0 || len >= sizeof(addrstr)) {
+    REST.set_response_status(response, REST.status.BAD_REQUEST);
+    return;
+  }
+  memcpy(addrstr, value, len);
+  addrstr[len] = '\0';
+  if(!uiplib_ipaddrconv(addrstr, &addr)) {
+    REST.set_response_status(response, REST.status.BAD_REQUEST);
+    return;
+  }
+
+  if(add) {
+    if(add_source(&addr) == NULL) {
+      REST.set_response_status(response, REST.status.SERVICE_UNAVAILABLE);
+      REST.set_response_payload(response, "TooManySources", 14);
+      return;
+    }
+    REST.set_response_status(response, REST.status.CREATED);
+  } else {
+    if((src = find_source(&addr)) == NULL) {
+      REST.set_response_status(response, REST.status.NOT_FOUND);
+      return;
+    }
+    remove_source(src);
+    REST.set_response_status(response, REST.status.DELETED);
   }
 }
 
@@ -271,9 +706,12 @@ PROCESS_THREAD(rest_server, ev, data)
   PRINTF("IP+UDP header: %u\n", UIP_IPUDPH_LEN);
   PRINTF("REST max chunk: %u\n", REST_MAX_CHUNK_SIZE);
 
+  binlog_init();
+
   /* Initialize the REST engine. */
   rest_init_engine();
   rest_activate_resource(&res_toggle, "threshold");
+  rest_activate_resource(&res_sources, "sources");
 
   while(1) {
     PROCESS_WAIT_EVENT(); // Wait for instructions
@@ -296,11 +734,17 @@ PROCESS_THREAD(activator, ev, data)
 
   etimer_set(&activator_timer, CLOCK_SECOND / fan_frequency);
   static int state = 0; // LED off
+  static int last_delta = -1;
   while(1) {
     PROCESS_WAIT_EVENT();
      if(etimer_expired(&activator_timer)) {
-      int mean_value = mean();
-      int delta = (mean_value - threshold) * (2 - rssi/100);
+      int mean_value = 0;
+      int rssi = 0;
+      int delta = 0;
+      if (aggregate(&mean_value, &rssi)) {
+        // mean_value is in centi-degrees, threshold in degrees
+        delta = ((long)mean_value - (long)threshold * 100) * (2 - rssi/100) / 100;
+      }
       if (delta > 0) {
         fan_frequency = delta;
         if (delta > 7) delta = 7; // max value = 7 (3 bits)
@@ -320,8 +764,12 @@ PROCESS_THREAD(activator, ev, data)
         state = 1;
       }
 
-      // Print for measurements
-      PRINTF("Fan Frq: %d, Delta: %d, Threshold: %d, Mean: %d, RSSI: %d \n", fan_frequency, delta, threshold, mean_value, rssi);
+      // Log for measurements, only when the fan changes
+      if(delta != last_delta) {
+        BINLOG_DEBUG(BINLOG5(EV_FAN, fan_frequency, delta, threshold,
+                             mean_value, rssi));
+        last_delta = delta;
+      }
       etimer_set(&activator_timer, CLOCK_SECOND / fan_frequency); // Adapt frequency: blink led
     }
   }
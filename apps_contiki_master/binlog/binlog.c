@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      Binary event log
+ */
+
+#include "binlog.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+/* id, argument length, time and the longest varints of all arguments */
+#define RECORD_MAX (4 + 5 * BINLOG_MAX_ARGS)
+
+static uint8_t ring[BINLOG_SIZE];
+static uint16_t head;       /* first byte of the oldest record */
+static uint16_t count;      /* bytes in use */
+static uint16_t dropped;    /* events lost since the last BINLOG_DROPPED */
+static uint8_t continued;   /* a PROCESS_EVENT_CONTINUE is queued for us */
+
+PROCESS(binlog_process, "Binary log");
+/*---------------------------------------------------------------------------*/
+static int
+put_varint(uint8_t *out, long value)
+{
+  /* zigzag: small negative values stay short */
+  unsigned long v = ((unsigned long)value << 1) ^ (value < 0 ? ~0UL : 0);
+  int len = 0;
+
+  while(v >= 0x80) {
+    out[len++] = (v & 0x7f) | 0x80;
+    v >>= 7;
+  }
+  out[len++] = v;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+store(uint8_t id, uint8_t argc, va_list ap)
+{
+  uint8_t record[RECORD_MAX];
+  uint16_t now = (uint16_t)clock_time();
+  int len = 4;
+  int i;
+
+  for(i = 0; i < argc && i < BINLOG_MAX_ARGS; i++) {
+    len += put_varint(&record[len], va_arg(ap, long));
+  }
+  record[0] = id;
+  record[1] = len - 4;
+  record[2] = now & 0xff;
+  record[3] = now >> 8;
+
+  if(count + len > BINLOG_SIZE) {
+    return 0;
+  }
+  for(i = 0; i < len; i++) {
+    ring[(head + count + i) % BINLOG_SIZE] = record[i];
+  }
+  count += len;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+binlog_event(uint8_t id, uint8_t argc, ...)
+{
+  va_list ap;
+  int stored;
+
+  va_start(ap, argc);
+  stored = store(id, argc, ap);
+  va_end(ap);
+
+  if(!stored) {
+    dropped++;
+    return 0;
+  }
+  process_poll(&binlog_process);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+log_dropped(uint8_t argc, ...)
+{
+  va_list ap;
+  int stored;
+
+  va_start(ap, argc);
+  stored = store(BINLOG_DROPPED, argc, ap);
+  va_end(ap);
+  return stored;
+}
+/*---------------------------------------------------------------------------*/
+static void
+write_record(void)
+{
+  static const char hex[] = "0123456789abcdef";
+  uint16_t len = 4 + ring[(head + 1) % BINLOG_SIZE];
+  uint8_t b;
+
+  putchar('#');
+  putchar('B');
+  count -= len;
+  while(len-- > 0) {
+    b = ring[head];
+    putchar(hex[b >> 4]);
+    putchar(hex[b & 0x0f]);
+    head = (head + 1) % BINLOG_SIZE;
+  }
+  putchar('\n');
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(binlog_process, ev, data)
+{
+  static uint8_t n;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL
+                             || ev == PROCESS_EVENT_CONTINUE);
+    if(ev == PROCESS_EVENT_CONTINUE) {
+      continued = 0;
+    }
+
+    for(n = 0; n < BINLOG_DRAIN && count > 0; n++) {
+      write_record();
+    }
+    if(dropped > 0 && log_dropped(1, (long)dropped)) {
+      dropped = 0;
+    }
+
+    /*
+     * Write more after the events already queued: a poll would run us
+     * again before any of them. Polling is only the fallback for a full
+     * event queue.
+     */
+    if(count > 0 && !continued) {
+      if(process_post(&binlog_process, PROCESS_EVENT_CONTINUE, NULL)
+         == PROCESS_ERR_OK) {
+        continued = 1;
+      } else {
+        process_poll(&binlog_process);
+      }
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+binlog_init(void)
+{
+  process_start(&binlog_process, NULL);
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      Binary event log
+ *
+ * Events are a numeric id and up to BINLOG_MAX_ARGS integer arguments.
+ * They are stored in a RAM ring buffer without any formatting, and a
+ * process writes them out a few at a time, one line per event. Between
+ * two turns it queues behind the events already posted to the other
+ * processes:
+ *
+ *   #B<hex of the record>\n
+ *
+ * A record is the id, the length of the arguments, the low 16 bits of
+ * clock_time() (little endian), then each argument as a zigzag LEB128
+ * varint. The lines go through putchar(), so they reach the host as
+ * debug lines of tunslip6 on a border router, or on the serial console of
+ * other motes. tools/binlog-decode.py turns them back into text with the
+ * event definitions of the firmware.
+ *
+ * Events written while the buffer is full are counted, and the count is
+ * logged as event BINLOG_DROPPED when there is room again.
+ *
+ * Diagnostics that would only be printed in a debug build are wrapped in
+ * BINLOG_DEBUG(), and only compiled in with BINLOG_CONF_LEVEL set to
+ * BINLOG_LEVEL_DEBUG.
+ */
+
+#ifndef BINLOG_H_
+#define BINLOG_H_
+
+#include "contiki.h"
+
+/* size of the ring buffer in bytes */
+#ifdef BINLOG_CONF_SIZE
+#define BINLOG_SIZE BINLOG_CONF_SIZE
+#else
+#define BINLOG_SIZE 128
+#endif
+
+/* events written each time the process runs */
+#ifdef BINLOG_CONF_DRAIN
+#define BINLOG_DRAIN BINLOG_CONF_DRAIN
+#else
+#define BINLOG_DRAIN 2
+#endif
+
+#define BINLOG_LEVEL_INFO  1
+#define BINLOG_LEVEL_DEBUG 2
+
+/* events of a higher level are compiled out */
+#ifdef BINLOG_CONF_LEVEL
+#define BINLOG_LEVEL BINLOG_CONF_LEVEL
+#else
+#define BINLOG_LEVEL BINLOG_LEVEL_INFO
+#endif
+
+#define BINLOG_MAX_ARGS 5
+
+/* reserved id, the argument is the number of events lost */
+#define BINLOG_DROPPED 0
+
+/**
+ * \brief Starts the process writing out the log
+ */
+void binlog_init(void);
+
+/**
+ * \brief Logs an event, not to be called from interrupts
+ * \param id The event id, 1-255
+ * \param argc The number of arguments that follow, at most BINLOG_MAX_ARGS
+ * \param ... The arguments, as long
+ * \return Nonzero if the event was stored, 0 if the log is full
+ */
+int binlog_event(uint8_t id, uint8_t argc, ...);
+
+#define BINLOG0(id)             binlog_event(id, 0)
+#define BINLOG1(id, a)          binlog_event(id, 1, (long)(a))
+#define BINLOG2(id, a, b)       binlog_event(id, 2, (long)(a), (long)(b))
+#define BINLOG3(id, a, b, c)    binlog_event(id, 3, (long)(a), (long)(b), \
+                                             (long)(c))
+#define BINLOG4(id, a, b, c, d) binlog_event(id, 4, (long)(a), (long)(b), \
+                                             (long)(c), (long)(d))
+#define BINLOG5(id, a, b, c, d, e) binlog_event(id, 5, (long)(a), (long)(b), \
+                                                (long)(c), (long)(d), (long)(e))
+
+/* e.g. BINLOG_DEBUG(BINLOG1(EV_RETRY, n)); */
+#if BINLOG_LEVEL >= BINLOG_LEVEL_DEBUG
+#define BINLOG_DEBUG(event) event
+#else
+#define BINLOG_DEBUG(event)
+#endif
+
+#endif /* BINLOG_H_ */
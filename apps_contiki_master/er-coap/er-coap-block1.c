@@ -39,6 +39,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "contiki.h"
+#include "lib/memb.h"
+#include "lib/list.h"
 #include "er-coap.h"
 #include "er-coap-block1.h"
 
@@ -53,6 +56,11 @@
 #define PRINTLLADDR(addr)
 #endif
 
+/*----------------------------------------------------------------------------*/
+#if COAP_BLOCK1_REASSEMBLY
+MEMB(block1_buffers_memb, coap_block1_buffer_t, COAP_BLOCK1_MAX_BUFFERS);
+LIST(block1_buffers_list);
+#endif /* COAP_BLOCK1_REASSEMBLY */
 /*----------------------------------------------------------------------------*/
 
 /**
@@ -117,3 +125,140 @@ coap_block1_handler(void *request, void *response, uint8_t *target, size_t *len,
 
   return 0;
 }
+/*----------------------------------------------------------------------------*/
+#if COAP_BLOCK1_REASSEMBLY
+static coap_block1_buffer_t *
+coap_block1_get_buffer(uip_ipaddr_t *addr, uint16_t port,
+                       const uint8_t *token, uint8_t token_len)
+{
+  coap_block1_buffer_t *b = NULL;
+  coap_block1_buffer_t *next = NULL;
+
+  for(b = (coap_block1_buffer_t *)list_head(block1_buffers_list); b; b = next) {
+    next = b->next;
+    if(timer_expired(&b->timer)) {
+      PRINTF("Blockwise: dropping expired block 1 upload (%u bytes)\n", b->len);
+      coap_block1_release(b);
+      continue;
+    }
+    if(uip_ipaddr_cmp(&b->addr, addr) && b->port == port
+       && b->token_len == token_len
+       && memcmp(b->token, token, token_len) == 0) {
+      return b;
+    }
+  }
+  return NULL;
+}
+/*----------------------------------------------------------------------------*/
+static coap_block1_buffer_t *
+coap_block1_new_buffer(uip_ipaddr_t *addr, uint16_t port,
+                       const uint8_t *token, uint8_t token_len)
+{
+  coap_block1_buffer_t *b = memb_alloc(&block1_buffers_memb);
+
+  if(b) {
+    uip_ipaddr_copy(&b->addr, addr);
+    b->port = port;
+    b->token_len = token_len;
+    memcpy(b->token, token, token_len);
+    b->len = 0;
+    list_add(block1_buffers_list, b);
+  }
+  return b;
+}
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Engine-level reassembly of Block1 requests
+ *
+ *        Called by the engine for every request carrying a Block1 option.
+ *        Blocks are collected in a buffer from a small pool, keyed by the
+ *        client endpoint and the token. Intermediate blocks are answered
+ *        with 2.31 Continue without calling the resource handler. Once the
+ *        last block arrived, the request payload points to the complete
+ *        body, so that the handler sees one request with the whole body.
+ *        Unfinished uploads expire after COAP_BLOCK1_TIMEOUT seconds.
+ *
+ * \param request   The parsed request, payload is replaced on completion
+ * \param response  The response, prepared as 2.31 for intermediate blocks
+ * \param addr      Client address
+ * \param port      Client port
+ * \param buffer    Set to the buffer holding the body on completion; it
+ *                  must be released with coap_block1_release() after the
+ *                  handler ran
+ *
+ * \return 1 if more blocks are expected
+ *         0 if the body is complete
+ *         -1 on error, erbium_status_code and coap_error_message are set
+ */
+int
+coap_block1_reassemble(coap_packet_t *request, coap_packet_t *response,
+                       uip_ipaddr_t *addr, uint16_t port,
+                       coap_block1_buffer_t **buffer)
+{
+  coap_block1_buffer_t *b = coap_block1_get_buffer(addr, port, request->token,
+                                                   request->token_len);
+
+  PRINTF("Blockwise: reassembling block 1 request: Num: %lu, More: %u, Size: %u, Offset: %lu\n",
+         request->block1_num, request->block1_more, request->block1_size,
+         request->block1_offset);
+
+  if(request->block1_num == 0) {
+    /* (re)start of an upload */
+    if(b == NULL
+       && (b = coap_block1_new_buffer(addr, port, request->token,
+                                      request->token_len)) == NULL) {
+      erbium_status_code = SERVICE_UNAVAILABLE_5_03;
+      coap_error_message = "NoFreeB1Buffer";
+      return -1;
+    }
+    b->len = 0;
+  } else if(b == NULL) {
+    erbium_status_code = REQUEST_ENTITY_INCOMPLETE_4_08;
+    coap_error_message = "NoBlock1Start";
+    return -1;
+  }
+
+  if(request->block1_offset + request->payload_len <= b->len) {
+    /* retransmission of a block already stored, acknowledge it again */
+    PRINTF("Blockwise: duplicate block 1 %lu\n", request->block1_num);
+  } else if(request->block1_offset != b->len) {
+    coap_block1_release(b);
+    erbium_status_code = REQUEST_ENTITY_INCOMPLETE_4_08;
+    coap_error_message = "MissingBlock1";
+    return -1;
+  } else if(b->len + request->payload_len > COAP_BLOCK1_MAX_BODY_SIZE) {
+    coap_block1_release(b);
+    erbium_status_code = REQUEST_ENTITY_TOO_LARGE_4_13;
+    coap_error_message = "Message to big";
+    return -1;
+  } else {
+    memcpy(b->body + b->len, request->payload, request->payload_len);
+    b->len += request->payload_len;
+  }
+  timer_set(&b->timer, COAP_BLOCK1_TIMEOUT * CLOCK_SECOND);
+
+  if(request->block1_more) {
+    coap_set_status_code(response, CONTINUE_2_31);
+    coap_set_header_block1(response, request->block1_num, 1,
+                           request->block1_size);
+    return 1;
+  }
+
+  /* hand the complete body over as if it came in one request */
+  request->payload = b->body;
+  request->payload_len = b->len;
+  request->block1_offset = 0;
+  *buffer = b;
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+void
+coap_block1_release(coap_block1_buffer_t *buffer)
+{
+  if(buffer) {
+    list_remove(block1_buffers_list, buffer);
+    memb_free(&block1_buffers_memb, buffer);
+  }
+}
+#endif /* COAP_BLOCK1_REASSEMBLY */
+/*----------------------------------------------------------------------------*/
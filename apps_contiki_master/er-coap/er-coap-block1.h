@@ -41,7 +41,28 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include "er-coap.h"
+
+/* reassembly buffer for a Block1 upload, keyed by client endpoint and token */
+typedef struct coap_block1_buffer {
+  struct coap_block1_buffer *next;      /* for LIST */
+
+  uip_ipaddr_t addr;
+  uint16_t port;
+  uint8_t token_len;
+  uint8_t token[COAP_TOKEN_LEN];
+
+  struct timer timer;                   /* expiry of an unfinished upload */
+
+  uint16_t len;
+  uint8_t body[COAP_BLOCK1_MAX_BODY_SIZE];
+} coap_block1_buffer_t;
 
 int coap_block1_handler(void *request, void *response, uint8_t *target, size_t *len, size_t max_len);
 
+int coap_block1_reassemble(coap_packet_t *request, coap_packet_t *response,
+                           uip_ipaddr_t *addr, uint16_t port,
+                           coap_block1_buffer_t **buffer);
+void coap_block1_release(coap_block1_buffer_t *buffer);
+
 #endif /* COAP_BLOCK1_H_ */
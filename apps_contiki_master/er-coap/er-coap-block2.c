@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *      CoAP module for Block2 continuation state
+ */
+
+#include <string.h>
+#include "contiki.h"
+#include "lib/memb.h"
+#include "lib/list.h"
+#include "er-coap-engine.h"
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#define PRINT6ADDR(addr) PRINTF("[%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x]", ((uint8_t *)addr)[0], ((uint8_t *)addr)[1], ((uint8_t *)addr)[2], ((uint8_t *)addr)[3], ((uint8_t *)addr)[4], ((uint8_t *)addr)[5], ((uint8_t *)addr)[6], ((uint8_t *)addr)[7], ((uint8_t *)addr)[8], ((uint8_t *)addr)[9], ((uint8_t *)addr)[10], ((uint8_t *)addr)[11], ((uint8_t *)addr)[12], ((uint8_t *)addr)[13], ((uint8_t *)addr)[14], ((uint8_t *)addr)[15])
+#define PRINTLLADDR(lladdr) PRINTF("[%02x:%02x:%02x:%02x:%02x:%02x]", (lladdr)->addr[0], (lladdr)->addr[1], (lladdr)->addr[2], (lladdr)->addr[3], (lladdr)->addr[4], (lladdr)->addr[5])
+#else
+#define PRINTF(...)
+#define PRINT6ADDR(addr)
+#define PRINTLLADDR(addr)
+#endif
+
+/*---------------------------------------------------------------------------*/
+MEMB(block2_cursors_memb, coap_block2_cursor_t, COAP_BLOCK2_MAX_CURSORS);
+LIST(block2_cursors_list);
+/*---------------------------------------------------------------------------*/
+/*- Internal API ------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/* the client is taken from the request currently handled by the engine */
+static coap_block2_cursor_t *
+find_cursor(const void *owner)
+{
+  coap_request_context_t *ctx = coap_get_request_context();
+  coap_block2_cursor_t *c = NULL;
+
+  for(c = (coap_block2_cursor_t *)list_head(block2_cursors_list); c;
+      c = c->next) {
+    if(c->owner == owner && c->port == ctx->port
+       && uip_ipaddr_cmp(&c->addr, &ctx->addr)) {
+      return c;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_cursor(coap_block2_cursor_t *c)
+{
+  list_remove(block2_cursors_list, c);
+  memb_free(&block2_cursors_memb, c);
+}
+/*---------------------------------------------------------------------------*/
+/*- Block2 Continuation API -------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Continue a blockwise representation where the last block stopped
+ *
+ *        Blockwise-aware handlers call this with the requested offset to
+ *        get the generator position stored by coap_block2_suspend() for
+ *        the same client. The state is only returned when it was stored
+ *        for exactly this offset, so that retransmissions or random access
+ *        fall back to generating from the start.
+ *
+ * \param owner   Generator the state belongs to, usually the resource
+ * \param offset  Offset of the requested block
+ * \param cursor  Returns the stored position
+ * \param pos     Returns the stored counter
+ *
+ * \return 1 if the state was found, 0 otherwise
+ */
+int
+coap_block2_resume(const void *owner, int32_t offset, const void **cursor,
+                   size_t *pos)
+{
+  coap_block2_cursor_t *c = find_cursor(owner);
+
+  if(c == NULL || timer_expired(&c->timer) || c->offset != offset) {
+    return 0;
+  }
+  PRINTF("Block2: resuming %p at %ld\n", owner, offset);
+  *cursor = c->cursor;
+  *pos = c->pos;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Store the generator position for the next block
+ *
+ *        When the pool is exhausted, an expired entry or the least recently
+ *        stored one is reused.
+ *
+ * \param owner   Generator the state belongs to
+ * \param offset  Offset of the next block
+ * \param cursor  Position to continue from
+ * \param pos     Counter to continue from
+ */
+void
+coap_block2_suspend(const void *owner, int32_t offset, const void *cursor,
+                    size_t pos)
+{
+  coap_request_context_t *ctx = coap_get_request_context();
+  coap_block2_cursor_t *c = find_cursor(owner);
+
+  if(c) {
+    list_remove(block2_cursors_list, c);
+  } else if((c = memb_alloc(&block2_cursors_memb)) == NULL) {
+    for(c = (coap_block2_cursor_t *)list_head(block2_cursors_list); c;
+        c = c->next) {
+      if(timer_expired(&c->timer)) {
+        break;
+      }
+    }
+    if(c == NULL) {
+      /* head is the least recently stored entry */
+      c = (coap_block2_cursor_t *)list_head(block2_cursors_list);
+    }
+    list_remove(block2_cursors_list, c);
+  }
+
+  uip_ipaddr_copy(&c->addr, &ctx->addr);
+  c->port = ctx->port;
+  c->owner = owner;
+  c->offset = offset;
+  c->cursor = cursor;
+  c->pos = pos;
+  timer_set(&c->timer, COAP_BLOCK2_TIMEOUT * CLOCK_SECOND);
+
+  list_add(block2_cursors_list, c);
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Drop the state once the last block was generated
+ */
+void
+coap_block2_discard(const void *owner)
+{
+  coap_block2_cursor_t *c = find_cursor(owner);
+
+  if(c) {
+    remove_cursor(c);
+  }
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *      CoAP module for Block2 continuation state
+ */
+
+#ifndef COAP_BLOCK2_H_
+#define COAP_BLOCK2_H_
+
+#include "er-coap.h"
+
+/* generator position kept between two blocks of the same client */
+typedef struct coap_block2_cursor {
+  struct coap_block2_cursor *next;      /* for LIST */
+
+  uip_ipaddr_t addr;
+  uint16_t port;
+  const void *owner;                    /* generator the state belongs to */
+
+  int32_t offset;                       /* block offset the state is valid for */
+  const void *cursor;                   /* generator defined position */
+  size_t pos;                           /* generator defined counter */
+
+  struct timer timer;
+} coap_block2_cursor_t;
+
+int coap_block2_resume(const void *owner, int32_t offset,
+                       const void **cursor, size_t *pos);
+void coap_block2_suspend(const void *owner, int32_t offset,
+                         const void *cursor, size_t pos);
+void coap_block2_discard(const void *owner);
+
+#endif /* COAP_BLOCK2_H_ */
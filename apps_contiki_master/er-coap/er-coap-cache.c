@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *      CoAP response cache for repeated GET requests
+ *
+ *      Representations that a handler marks with a Max-Age are kept and
+ *      served to further GETs for the same Uri-Path, Uri-Query, Proxy-Uri,
+ *      and Accept without calling the handler again. Each entry carries an ETag (hash
+ *      of the payload), so clients can revalidate and get a 2.03 Valid.
+ *      Observe and blockwise requests always go to the handler, and POST,
+ *      PUT, or DELETE to a path drop the entries of that path. Resources
+ *      that change the representation of another path drop its entries
+ *      with coap_cache_invalidate().
+ */
+
+#include <string.h>
+#include "er-coap-cache.h"
+
+/* Compile this code only if the response cache is enabled */
+#if COAP_CACHE
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+static coap_cache_entry_t entries[COAP_CACHE_ENTRIES];
+
+/*---------------------------------------------------------------------------*/
+/*- Internal API ------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/* djb2 */
+static uint32_t
+hash(const uint8_t *data, size_t len)
+{
+  uint32_t hash = 5381;
+
+  while(len--) {
+    hash = (hash << 5) + hash + *data++;
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+/* append a length-prefixed field, 0 if it does not fit */
+static int
+add_field(coap_cache_key_t *key, const void *data, size_t len)
+{
+  if(len > 0xFF || key->len + 1 + len > sizeof(key->data)) {
+    return 0;
+  }
+  key->data[key->len++] = (uint8_t)len;
+  memcpy(&key->data[key->len], data, len);
+  key->len += len;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static coap_cache_entry_t *
+find_entry(const coap_cache_key_t *key)
+{
+  int i;
+
+  for(i = 0; i < COAP_CACHE_ENTRIES; ++i) {
+    if(entries[i].key.len && coap_cache_key_equal(&entries[i].key, key)) {
+      if(stimer_expired(&entries[i].expires)) {
+        entries[i].key.len = 0;
+        return NULL;
+      }
+      return &entries[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*- Response Cache API ------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Cache key of a request
+ *
+ *        key->len is 0 if the request cannot be answered from the cache,
+ *        e.g., because its URI is longer than COAP_CACHE_MAX_KEY.
+ */
+void
+coap_cache_key(coap_packet_t *request, coap_cache_key_t *key)
+{
+  const char *path = NULL;
+  const char *query = NULL;
+  size_t path_len = coap_get_header_uri_path(request, &path);
+  size_t query_len = coap_get_header_uri_query(request, &query);
+
+  key->len = 0;
+  if(request->code != COAP_GET || IS_OPTION(request, COAP_OPTION_OBSERVE)
+     || IS_OPTION(request, COAP_OPTION_BLOCK1)
+     || IS_OPTION(request, COAP_OPTION_BLOCK2)
+     || path_len + query_len + request->proxy_uri_len > COAP_CACHE_MAX_KEY) {
+    return;
+  }
+
+  /* proxied requests are cached by target */
+  add_field(key, path, path_len);
+  add_field(key, query, query_len);
+  add_field(key, request->proxy_uri, request->proxy_uri_len);
+  if(IS_OPTION(request, COAP_OPTION_ACCEPT)) {
+    key->data[key->len++] = (uint8_t)(request->accept >> 8);
+    key->data[key->len++] = (uint8_t)request->accept;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Whether two requests get the same cached representation
+ */
+int
+coap_cache_key_equal(const coap_cache_key_t *a, const coap_cache_key_t *b)
+{
+  return a->len == b->len && memcmp(a->data, b->data, a->len) == 0;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Drop the cached representations of a path
+ *
+ *        Called by the engine for requests that may change a resource, and
+ *        by resources whose change affects the representation of another.
+ */
+void
+coap_cache_invalidate(const char *path, size_t len)
+{
+  int i;
+
+  for(i = 0; i < COAP_CACHE_ENTRIES; ++i) {
+    /* the key starts with the length-prefixed Uri-Path */
+    if(entries[i].key.len && entries[i].key.data[0] == len
+       && memcmp(&entries[i].key.data[1], path, len) == 0) {
+      PRINTF("Cache: invalidated %.*s\n", (int)len, path);
+      entries[i].key.len = 0;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Answer a GET from the cache
+ *
+ *        A request carrying the ETag of the cached entry gets 2.03 Valid
+ *        without payload, otherwise 2.05 with the cached payload. Max-Age is
+ *        set to the remaining lifetime of the entry.
+ *
+ * \return 1 if the response was prepared from the cache, 0 on a miss
+ */
+int
+coap_cache_lookup(coap_packet_t *request, coap_packet_t *response,
+                  const coap_cache_key_t *key)
+{
+  coap_cache_entry_t *e = find_entry(key);
+  const uint8_t *etag = NULL;
+
+  if(e == NULL) {
+    return 0;
+  }
+
+  PRINTF("Cache: hit\n");
+  coap_set_header_etag(response, e->etag, sizeof(e->etag));
+  coap_set_header_max_age(response, stimer_remaining(&e->expires));
+
+  if(coap_get_header_etag(request, &etag) == sizeof(e->etag)
+     && memcmp(etag, e->etag, sizeof(e->etag)) == 0) {
+    coap_set_status_code(response, VALID_2_03);
+  } else {
+    coap_set_status_code(response, CONTENT_2_05);
+    if(e->content_format >= 0) {
+      coap_set_header_content_format(response, e->content_format);
+    }
+    coap_set_payload(response, e->payload, e->payload_len);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Keep the response of a handler for further GETs
+ *
+ *        Only complete 2.05 responses with a Max-Age set by the handler are
+ *        kept. The ETag of the entry is added to the response, so the
+ *        client can revalidate later. When the cache is full, the entry
+ *        closest to expiry is replaced.
+ *
+ * \param response    The response prepared by the handler
+ * \param key         Key computed before the handler ran
+ * \param new_offset  Offset returned by the handler, 0 if not blockwise
+ */
+void
+coap_cache_store(coap_packet_t *response, const coap_cache_key_t *key,
+                 int32_t new_offset)
+{
+  coap_cache_entry_t *e = NULL;
+  uint32_t etag;
+  int i;
+
+  if(response->code != CONTENT_2_05 || new_offset != 0
+     || !IS_OPTION(response, COAP_OPTION_MAX_AGE) || response->max_age == 0
+     || IS_OPTION(response, COAP_OPTION_OBSERVE)
+     || response->payload_len > COAP_CACHE_MAX_PAYLOAD) {
+    return;
+  }
+
+  for(i = 0; i < COAP_CACHE_ENTRIES; ++i) {
+    if(entries[i].key.len == 0 || coap_cache_key_equal(&entries[i].key, key)
+       || stimer_expired(&entries[i].expires)) {
+      e = &entries[i];
+      break;
+    }
+    if(e == NULL || stimer_remaining(&entries[i].expires)
+       < stimer_remaining(&e->expires)) {
+      e = &entries[i];
+    }
+  }
+
+  etag = hash(response->payload, response->payload_len);
+
+  memcpy(&e->key, key, sizeof(e->key));
+  stimer_set(&e->expires, response->max_age);
+  memcpy(e->etag, &etag, sizeof(e->etag));
+  e->content_format = IS_OPTION(response, COAP_OPTION_CONTENT_FORMAT)
+    ? (int16_t)response->content_format : -1;
+  e->payload_len = response->payload_len;
+  memcpy(e->payload, response->payload, response->payload_len);
+
+  if(!IS_OPTION(response, COAP_OPTION_ETAG)) {
+    coap_set_header_etag(response, e->etag, sizeof(e->etag));
+  }
+  PRINTF("Cache: stored for %lu s\n", response->max_age);
+}
+/*---------------------------------------------------------------------------*/
+#endif /* COAP_CACHE */
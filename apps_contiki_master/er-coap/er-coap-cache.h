@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *      CoAP response cache for repeated GET requests
+ */
+
+#ifndef COAP_CACHE_H_
+#define COAP_CACHE_H_
+
+#include "er-coap.h"
+#include "stimer.h"
+
+/*
+ * What a cached representation is looked up by: Uri-Path, Uri-Query,
+ * Proxy-Uri, and Accept of the GET, each prefixed with its length
+ */
+typedef struct coap_cache_key {
+  uint8_t len;                  /* 0 if the request cannot be cached */
+  uint8_t data[COAP_CACHE_MAX_KEY + 5];
+} coap_cache_key_t;
+
+/* cached representation of a GET */
+typedef struct coap_cache_entry {
+  coap_cache_key_t key;         /* key.len 0 if unused */
+  struct stimer expires;        /* Max-Age set by the handler */
+  uint8_t etag[4];              /* hash of the payload */
+  int16_t content_format;       /* -1 if not set */
+  uint16_t payload_len;
+  uint8_t payload[COAP_CACHE_MAX_PAYLOAD];
+} coap_cache_entry_t;
+
+void coap_cache_key(coap_packet_t *request, coap_cache_key_t *key);
+int coap_cache_key_equal(const coap_cache_key_t *a, const coap_cache_key_t *b);
+void coap_cache_invalidate(const char *path, size_t len);
+int coap_cache_lookup(coap_packet_t *request, coap_packet_t *response,
+                      const coap_cache_key_t *key);
+void coap_cache_store(coap_packet_t *response, const coap_cache_key_t *key,
+                      int32_t new_offset);
+
+#endif /* COAP_CACHE_H_ */
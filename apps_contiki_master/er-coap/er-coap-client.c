@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *      Asynchronous CoAP client with per-request contexts
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "er-coap.h"
+#include "er-coap-client.h"
+
+/* Compile this code only if the asynchronous client is required */
+#if COAP_ASYNC_CLIENT
+
+#define DEBUG 0
+#if DEBUG
+#define PRINTF(...) printf(__VA_ARGS__)
+#define PRINT6ADDR(addr) PRINTF("[%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x]", ((uint8_t *)addr)[0], ((uint8_t *)addr)[1], ((uint8_t *)addr)[2], ((uint8_t *)addr)[3], ((uint8_t *)addr)[4], ((uint8_t *)addr)[5], ((uint8_t *)addr)[6], ((uint8_t *)addr)[7], ((uint8_t *)addr)[8], ((uint8_t *)addr)[9], ((uint8_t *)addr)[10], ((uint8_t *)addr)[11], ((uint8_t *)addr)[12], ((uint8_t *)addr)[13], ((uint8_t *)addr)[14], ((uint8_t *)addr)[15])
+#define PRINTLLADDR(lladdr) PRINTF("[%02x:%02x:%02x:%02x:%02x:%02x]", (lladdr)->addr[0], (lladdr)->addr[1], (lladdr)->addr[2], (lladdr)->addr[3], (lladdr)->addr[4], (lladdr)->addr[5])
+#else
+#define PRINTF(...)
+#define PRINT6ADDR(addr)
+#define PRINTLLADDR(addr)
+#endif
+
+MEMB(async_requests_memb, coap_async_request_t, COAP_MAX_ASYNC_REQUESTS);
+LIST(async_requests_list);
+
+/*----------------------------------------------------------------------------*/
+static void
+free_request(coap_async_request_t *r)
+{
+  if(r->transaction) {
+    coap_clear_transaction(r->transaction);
+    r->transaction = NULL;
+  }
+  ctimer_stop(&r->separate_timer);
+  list_remove(async_requests_list, r);
+  memb_free(&async_requests_memb, r);
+}
+/*----------------------------------------------------------------------------*/
+static void handle_response(void *data, void *response);
+
+static int
+send_request(coap_async_request_t *r)
+{
+  coap_packet_t request[1];
+
+  coap_init_message(request, COAP_TYPE_CON, r->method, coap_get_mid());
+  coap_set_header_uri_path(request, r->uri);
+  if(r->query) {
+    coap_set_header_uri_query(request, r->query);
+  }
+  coap_set_token(request, r->token, r->token_len);
+  if(r->block_num > 0) {
+    coap_set_header_block2(request, r->block_num, 0, r->block_size);
+  } else if(r->payload_len) {
+    /* the payload only goes with the initial request */
+    coap_set_payload(request, r->payload, r->payload_len);
+  }
+
+  if((r->transaction = coap_new_transaction(request->mid, &r->addr,
+                                            r->port)) == NULL) {
+    PRINTF("Could not allocate transaction buffer\n");
+    return 0;
+  }
+  r->transaction->callback = handle_response;
+  r->transaction->callback_data = r;
+  r->transaction->packet_len = coap_serialize_message(request,
+                                                      r->transaction->packet);
+  coap_send_transaction(r->transaction);
+
+  PRINTF("Async request %p: #%lu (MID %u)\n", r, r->block_num, request->mid);
+  return 1;
+}
+/*----------------------------------------------------------------------------*/
+static void
+separate_timeout(void *data)
+{
+  coap_async_request_t *r = (coap_async_request_t *)data;
+
+  PRINTF("Async request %p: no separate response\n", r);
+  r->callback(r, NULL, COAP_ASYNC_TIMEOUT);
+  free_request(r);
+}
+/*----------------------------------------------------------------------------*/
+static void
+handle_packet(coap_async_request_t *r, coap_packet_t *packet)
+{
+  uint32_t num = 0;
+  uint8_t more = 0;
+  uint16_t size = 0;
+
+  if(!coap_get_header_block2(packet, &num, &more, &size, NULL)) {
+    more = 0;
+  } else if(num != r->block_num) {
+    PRINTF("Async request %p: got block %lu instead of %lu\n", r, num,
+           r->block_num);
+    r->callback(r, NULL, COAP_ASYNC_ERROR);
+    free_request(r);
+    return;
+  }
+
+  if(!more) {
+    r->callback(r, packet, COAP_ASYNC_DONE);
+    free_request(r);
+    return;
+  }
+
+  r->block_num = num + 1;
+  r->block_size = MIN(size, REST_MAX_CHUNK_SIZE);
+  if(r->callback(r, packet, COAP_ASYNC_BLOCK) == 0) {
+    coap_async_continue(r);
+  }
+}
+/*----------------------------------------------------------------------------*/
+static void
+handle_response(void *data, void *response)
+{
+  coap_async_request_t *r = (coap_async_request_t *)data;
+  coap_packet_t *packet = (coap_packet_t *)response;
+
+  /* the engine already freed the transaction */
+  r->transaction = NULL;
+
+  if(packet == NULL) {
+    PRINTF("Async request %p: timeout\n", r);
+    r->callback(r, NULL, COAP_ASYNC_TIMEOUT);
+    free_request(r);
+    return;
+  }
+
+  if(packet->type == COAP_TYPE_RST) {
+    PRINTF("Async request %p: reset by the server\n", r);
+    r->callback(r, NULL, COAP_ASYNC_ERROR);
+    free_request(r);
+    return;
+  }
+
+  if(packet->code == 0) {
+    /* empty ACK: the response follows in its own message, with our token */
+    PRINTF("Async request %p: waiting for the separate response\n", r);
+    r->separate = 1;
+    ctimer_set(&r->separate_timer, COAP_ASYNC_SEPARATE_TIMEOUT,
+               separate_timeout, r);
+    return;
+  }
+
+  handle_packet(r, packet);
+}
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Hand a CON or NON response over to the request it answers
+ *
+ *        Called by the engine for responses that match no transaction.
+ *        A separate response is matched to its request by the token and
+ *        the server, and acknowledged if it is confirmable.
+ *
+ * \return 1 if the response belonged to a request, 0 otherwise
+ */
+int
+coap_async_handle_separate(uip_ipaddr_t *addr, uint16_t port,
+                           coap_packet_t *response)
+{
+  coap_async_request_t *r;
+
+  if(response->code == 0) {
+    return 0;
+  }
+  for(r = (coap_async_request_t *)list_head(async_requests_list); r;
+      r = r->next) {
+    if(r->separate && r->port == port && uip_ipaddr_cmp(&r->addr, addr)
+       && r->token_len == response->token_len
+       && memcmp(r->token, response->token, r->token_len) == 0) {
+      break;
+    }
+  }
+  if(r == NULL) {
+    return 0;
+  }
+
+  if(response->type == COAP_TYPE_CON) {
+    coap_packet_t ack[1];
+
+    coap_init_message(ack, COAP_TYPE_ACK, 0, response->mid);
+    coap_send_message(addr, port, uip_appdata,
+                      coap_serialize_message(ack, uip_appdata));
+  }
+  PRINTF("Async request %p: separate response\n", r);
+  r->separate = 0;
+  ctimer_stop(&r->separate_timer);
+  handle_packet(r, response);
+  return 1;
+}
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Start a request and return without waiting for the response
+ *
+ *        Each request has its own context taken from a small pool, so
+ *        several processes can have requests in progress at the same time.
+ *        Block2 responses are followed automatically, the callback is
+ *        called for every block.
+ *
+ * \param addr         Server address
+ * \param port         Server port (network byte order)
+ * \param method       COAP_GET, COAP_POST, COAP_PUT, or COAP_DELETE
+ * \param uri          Uri-Path, must stay valid until the request ends
+ * \param query        Uri-Query or NULL, same lifetime as uri
+ * \param payload      Request payload or NULL, same lifetime as uri
+ * \param payload_len  Length of the payload
+ * \param callback     Response callback
+ * \param data         User data, available as request->data
+ *
+ * \return The request context, NULL if no context or transaction is free
+ */
+coap_async_request_t *
+coap_async_request(uip_ipaddr_t *addr, uint16_t port, coap_method_t method,
+                   const char *uri, const char *query, const uint8_t *payload,
+                   uint16_t payload_len, coap_async_callback_t callback,
+                   void *data)
+{
+  static uint16_t token = 0;
+  coap_async_request_t *r;
+
+  if(callback == NULL || (r = memb_alloc(&async_requests_memb)) == NULL) {
+    PRINTF("Could not allocate async request\n");
+    return NULL;
+  }
+  memset(r, 0, sizeof(coap_async_request_t));
+  uip_ipaddr_copy(&r->addr, addr);
+  r->port = port;
+  r->method = method;
+  r->uri = uri;
+  r->query = query;
+  r->payload = payload;
+  r->payload_len = payload_len;
+  r->block_size = REST_MAX_CHUNK_SIZE;
+  r->callback = callback;
+  r->data = data;
+
+  /* MIDs match piggybacked responses, the token separate ones */
+  ++token;
+  r->token_len = sizeof(token);
+  memcpy(r->token, &token, sizeof(token));
+
+  list_add(async_requests_list, r);
+
+  if(!send_request(r)) {
+    free_request(r);
+    return NULL;
+  }
+  return r;
+}
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Request the next block of a transfer paused by the callback
+ *
+ * \return 1 if the request was sent, 0 otherwise; on failure the callback
+ *         gets COAP_ASYNC_ERROR and the context is freed
+ */
+int
+coap_async_continue(coap_async_request_t *request)
+{
+  if(request->transaction) {
+    /* already in progress */
+    return 1;
+  }
+  if(!send_request(request)) {
+    request->callback(request, NULL, COAP_ASYNC_ERROR);
+    free_request(request);
+    return 0;
+  }
+  return 1;
+}
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Abort a request; the callback is not called anymore
+ */
+void
+coap_async_cancel(coap_async_request_t *request)
+{
+  PRINTF("Async request %p: cancelled\n", request);
+  free_request(request);
+}
+/*----------------------------------------------------------------------------*/
+#endif /* COAP_ASYNC_CLIENT */
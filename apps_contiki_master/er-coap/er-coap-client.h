@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *      Asynchronous CoAP client with per-request contexts
+ */
+
+#ifndef COAP_CLIENT_H_
+#define COAP_CLIENT_H_
+
+#include "er-coap.h"
+#include "er-coap-transactions.h"
+
+#ifndef COAP_ASYNC_CLIENT
+#define COAP_ASYNC_CLIENT 0
+#endif
+
+/* Number of requests that can be in progress at the same time. */
+#ifdef COAP_CONF_MAX_ASYNC_REQUESTS
+#define COAP_MAX_ASYNC_REQUESTS COAP_CONF_MAX_ASYNC_REQUESTS
+#else
+#define COAP_MAX_ASYNC_REQUESTS 2
+#endif /* COAP_CONF_MAX_ASYNC_REQUESTS */
+
+/* How long a separate response is waited for after its empty ACK. */
+#ifdef COAP_CONF_ASYNC_SEPARATE_TIMEOUT
+#define COAP_ASYNC_SEPARATE_TIMEOUT COAP_CONF_ASYNC_SEPARATE_TIMEOUT
+#else
+#define COAP_ASYNC_SEPARATE_TIMEOUT (30 * CLOCK_SECOND)
+#endif /* COAP_CONF_ASYNC_SEPARATE_TIMEOUT */
+
+/*----------------------------------------------------------------------------*/
+typedef enum {
+  COAP_ASYNC_BLOCK,             /* response block, more will follow */
+  COAP_ASYNC_DONE,              /* last (or only) response */
+  COAP_ASYNC_TIMEOUT,           /* no reply (or separate response) from
+                                   server */
+  COAP_ASYNC_ERROR,             /* request could not be sent, the server
+                                   reset it or sent the wrong block */
+} coap_async_flag_t;
+
+/*----------------------------------------------------------------------------*/
+typedef struct coap_async_request_s coap_async_request_t;
+
+/*
+ * Called for every response block and once with DONE, TIMEOUT, or ERROR.
+ * The response (NULL unless BLOCK or DONE) is only valid during the call.
+ * Returning non-zero for a BLOCK pauses the transfer until
+ * coap_async_continue(). The context is freed after DONE, TIMEOUT, or ERROR.
+ * A transfer cancelled from within the callback must return non-zero.
+ */
+typedef int (*coap_async_callback_t)(coap_async_request_t *request,
+                                     coap_packet_t *response,
+                                     coap_async_flag_t flag);
+
+struct coap_async_request_s {
+  coap_async_request_t *next;   /* for LIST */
+  uip_ipaddr_t addr;
+  uint16_t port;
+  coap_method_t method;
+  const char *uri;              /* kept by the caller until the request ends */
+  const char *query;
+  const uint8_t *payload;
+  uint16_t payload_len;
+  uint8_t token_len;
+  uint8_t token[COAP_TOKEN_LEN];
+  uint32_t block_num;           /* next Block2 to request */
+  uint16_t block_size;
+  coap_transaction_t *transaction;
+  uint8_t separate;             /* empty ACK received, response pending */
+  struct ctimer separate_timer;
+  coap_async_callback_t callback;
+  void *data;                   /* generic pointer for storing user data */
+};
+
+/*----------------------------------------------------------------------------*/
+coap_async_request_t *coap_async_request(uip_ipaddr_t *addr, uint16_t port,
+                                         coap_method_t method,
+                                         const char *uri, const char *query,
+                                         const uint8_t *payload,
+                                         uint16_t payload_len,
+                                         coap_async_callback_t callback,
+                                         void *data);
+
+int coap_async_continue(coap_async_request_t *request);
+
+void coap_async_cancel(coap_async_request_t *request);
+
+int coap_async_handle_separate(uip_ipaddr_t *addr, uint16_t port,
+                               coap_packet_t *response);
+
+#endif /* COAP_CLIENT_H_ */
@@ -40,8 +40,14 @@
 #define ER_COAP_CONF_H_
 
 /* Features that can be disabled to achieve smaller memory footprint */
+#ifndef COAP_LINK_FORMAT_FILTERING
 #define COAP_LINK_FORMAT_FILTERING     0
+#endif /* COAP_LINK_FORMAT_FILTERING */
+
+/* Accept Proxy-Uri/Proxy-Scheme and pass such requests to the proxy callback. */
+#ifndef COAP_PROXY_OPTION_PROCESSING
 #define COAP_PROXY_OPTION_PROCESSING   0
+#endif /* COAP_PROXY_OPTION_PROCESSING */
 
 /* Listening port for the CoAP REST Engine */
 #ifndef COAP_SERVER_PORT
@@ -53,11 +59,38 @@
 #define COAP_MAX_OPEN_TRANSACTIONS     4
 #endif /* COAP_MAX_OPEN_TRANSACTIONS */
 
+/* Incoming messages that can be handled at the same time, each context holds two packets. */
+#ifndef COAP_MAX_REQUEST_CONTEXTS
+#define COAP_MAX_REQUEST_CONTEXTS      1
+#endif /* COAP_MAX_REQUEST_CONTEXTS */
+
+/* Transport driver: coap_uip_transport, or coap_native_transport for host UDP sockets on the native target. */
+#ifdef COAP_CONF_TRANSPORT
+#define COAP_TRANSPORT COAP_CONF_TRANSPORT
+#else /* COAP_CONF_TRANSPORT */
+#define COAP_TRANSPORT coap_uip_transport
+#endif /* COAP_CONF_TRANSPORT */
+
+/* Engine instances forked by coap_native_transport to share the CoAP port. */
+#ifndef COAP_NATIVE_WORKERS
+#define COAP_NATIVE_WORKERS            1
+#endif /* COAP_NATIVE_WORKERS */
+
+/* Datagrams moved per recvmmsg()/sendmmsg() call by coap_native_transport. */
+#ifndef COAP_NATIVE_BATCH
+#define COAP_NATIVE_BATCH              16
+#endif /* COAP_NATIVE_BATCH */
+
 /* Maximum number of failed request attempts before action */
 #ifndef COAP_MAX_ATTEMPTS
 #define COAP_MAX_ATTEMPTS              4
 #endif /* COAP_MAX_ATTEMPTS */
 
+/* Block requests kept in flight by coap_blocking_request(), keep it within the server's NSTART. */
+#ifndef COAP_BLOCKING_REQUEST_WINDOW
+#define COAP_BLOCKING_REQUEST_WINDOW   2
+#endif /* COAP_BLOCKING_REQUEST_WINDOW */
+
 /* Conservative size limit, as not all options have to be set at the same time. Check when Proxy-Uri option is used */
 #ifndef COAP_MAX_HEADER_SIZE    /*     Hdr                  CoF  If-Match         Obs Blo strings   */
 #define COAP_MAX_HEADER_SIZE           (4 + COAP_TOKEN_LEN + 3 + 1 + COAP_ETAG_LEN + 4 + 4 + 30)  /* 65 */
@@ -68,7 +101,62 @@
 #define COAP_MAX_OBSERVERS    COAP_MAX_OPEN_TRANSACTIONS - 1
 #endif /* COAP_MAX_OBSERVERS */
 
+/* Requests that can wait in the pooled separate response queue. */
+#ifndef COAP_MAX_SEPARATE_WAITERS
+#define COAP_MAX_SEPARATE_WAITERS      2
+#endif /* COAP_MAX_SEPARATE_WAITERS */
+
 /* Interval in notifies in which NON notifies are changed to CON notifies to check client. */
 #define COAP_OBSERVE_REFRESH_INTERVAL  20
 
+/* Engine-level reassembly of Block1 requests, handlers then receive the complete body once. */
+#ifndef COAP_BLOCK1_REASSEMBLY
+#define COAP_BLOCK1_REASSEMBLY         0
+#endif /* COAP_BLOCK1_REASSEMBLY */
+
+/* Number of concurrent Block1 uploads that can be reassembled. */
+#ifndef COAP_BLOCK1_MAX_BUFFERS
+#define COAP_BLOCK1_MAX_BUFFERS        2
+#endif /* COAP_BLOCK1_MAX_BUFFERS */
+
+/* Largest request body that can be reassembled (each buffer takes that much RAM). */
+#ifndef COAP_BLOCK1_MAX_BODY_SIZE
+#define COAP_BLOCK1_MAX_BODY_SIZE      256
+#endif /* COAP_BLOCK1_MAX_BODY_SIZE */
+
+/* Seconds after the last received block before an unfinished upload is dropped. */
+#ifndef COAP_BLOCK1_TIMEOUT
+#define COAP_BLOCK1_TIMEOUT            30
+#endif /* COAP_BLOCK1_TIMEOUT */
+
+/* Number of clients for which a Block2 generator position is kept between blocks. */
+#ifndef COAP_BLOCK2_MAX_CURSORS
+#define COAP_BLOCK2_MAX_CURSORS        2
+#endif /* COAP_BLOCK2_MAX_CURSORS */
+
+/* Seconds a Block2 generator position stays valid without a follow-up request. */
+#ifndef COAP_BLOCK2_TIMEOUT
+#define COAP_BLOCK2_TIMEOUT            10
+#endif /* COAP_BLOCK2_TIMEOUT */
+
+/* Serve repeated GETs from a cache of responses that carry a Max-Age. */
+#ifndef COAP_CACHE
+#define COAP_CACHE                     0
+#endif /* COAP_CACHE */
+
+/* Number of cached responses. */
+#ifndef COAP_CACHE_ENTRIES
+#define COAP_CACHE_ENTRIES             2
+#endif /* COAP_CACHE_ENTRIES */
+
+/* Largest payload that is cached (each entry takes that much RAM). */
+#ifndef COAP_CACHE_MAX_PAYLOAD
+#define COAP_CACHE_MAX_PAYLOAD         REST_MAX_CHUNK_SIZE
+#endif /* COAP_CACHE_MAX_PAYLOAD */
+
+/* Longest Uri-Path, Uri-Query, and Proxy-Uri together that are cached. */
+#ifndef COAP_CACHE_MAX_KEY
+#define COAP_CACHE_MAX_KEY             48
+#endif /* COAP_CACHE_MAX_KEY */
+
 #endif /* ER_COAP_CONF_H_ */
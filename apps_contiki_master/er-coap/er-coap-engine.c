@@ -41,6 +41,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "er-coap-engine.h"
+#include "er-coap-block1.h"
 
 #define DEBUG 0
 #if DEBUG
@@ -60,32 +61,62 @@ PROCESS(coap_engine, "CoAP Engine");
 /*- Variables ---------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 static service_callback_t service_cbk = NULL;
+#if COAP_PROXY_OPTION_PROCESSING
+static service_callback_t proxy_cbk = NULL;
+#endif
+
+/* contexts are pooled instead of on the stack to keep stack peaks low */
+MEMB(request_contexts_memb, coap_request_context_t, COAP_MAX_REQUEST_CONTEXTS);
+static coap_request_context_t *current_context = NULL;
 
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
-static int
-coap_receive(void)
+/**
+ * \brief Handle one datagram received on the CoAP port
+ *
+ *        The data buffer is reused for error replies, so it must be
+ *        writable and large enough for a short error message.
+ *
+ * \param addr  Source address
+ * \param port  Source port (network byte order)
+ * \param data  Datagram payload
+ * \param len   Length of the payload
+ *
+ * \return erbium_status_code after handling
+ */
+int
+coap_engine_receive(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
+                    uint16_t len)
 {
+  coap_request_context_t *ctx = NULL;
+  coap_request_context_t *previous = current_context;
+  coap_packet_t *message = NULL;
+  coap_packet_t *response = NULL;
+  coap_transaction_t *transaction = NULL;
+
   erbium_status_code = NO_ERROR;
 
-  PRINTF("handle_incoming_data(): received uip_datalen=%u \n",
-         (uint16_t)uip_datalen());
+  PRINTF("handle_incoming_data(): received datalen=%u \n", len);
 
-  /* static declaration reduces stack peaks and program code size */
-  static coap_packet_t message[1]; /* this way the packet can be treated as pointer as usual */
-  static coap_packet_t response[1];
-  static coap_transaction_t *transaction = NULL;
+  if(len > 0) {
 
-  if(uip_newdata()) {
+    if((ctx = memb_alloc(&request_contexts_memb)) == NULL) {
+      PRINTF("No free request context, dropping message\n");
+      return SERVICE_UNAVAILABLE_5_03;
+    }
+    message = ctx->message;
+    response = ctx->response;
+    ctx->transaction = NULL;
+    uip_ipaddr_copy(&ctx->addr, addr);
+    ctx->port = port;
+    current_context = ctx;
 
     PRINTF("receiving UDP datagram from: ");
-    PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
-    PRINTF(":%u\n  Length: %u\n", uip_ntohs(UIP_UDP_BUF->srcport),
-           uip_datalen());
+    PRINT6ADDR(addr);
+    PRINTF(":%u\n  Length: %u\n", uip_ntohs(port), len);
 
-    erbium_status_code =
-      coap_parse_message(message, uip_appdata, uip_datalen());
+    erbium_status_code = coap_parse_message(message, data, len);
 
     if(erbium_status_code == NO_ERROR) {
 
@@ -101,12 +132,31 @@ coap_receive(void)
 
         /* use transaction buffer for response to confirmable request */
         if((transaction =
-              coap_new_transaction(message->mid, &UIP_IP_BUF->srcipaddr,
-                                   UIP_UDP_BUF->srcport))) {
+              coap_new_transaction(message->mid, &ctx->addr, ctx->port))) {
           uint32_t block_num = 0;
           uint16_t block_size = REST_MAX_CHUNK_SIZE;
           uint32_t block_offset = 0;
           int32_t new_offset = 0;
+          int block1_state = 0;
+#if COAP_BLOCK1_REASSEMBLY
+          coap_block1_buffer_t *block1_buffer = NULL;
+#endif
+#if COAP_CACHE
+          coap_cache_key_t cache_key;
+#endif
+
+          ctx->transaction = transaction;
+#if COAP_CACHE
+          /* before the handler, which may modify the query in place */
+          coap_cache_key(message, &cache_key);
+
+          if(message->code != COAP_GET) {
+            const char *path = NULL;
+            size_t path_len = coap_get_header_uri_path(message, &path);
+
+            coap_cache_invalidate(path, path_len);
+          }
+#endif
 
           /* prepare response */
           if(message->type == COAP_TYPE_CON) {
@@ -130,8 +180,49 @@ coap_receive(void)
             new_offset = block_offset;
           }
 
+#if COAP_BLOCK1_REASSEMBLY
+          /* collect Block1 uploads before the resource handler sees them */
+          if(IS_OPTION(message, COAP_OPTION_BLOCK1)) {
+            block1_state =
+              coap_block1_reassemble(message, response, &ctx->addr,
+                                     ctx->port, &block1_buffer);
+          }
+#endif
+
           /* invoke resource handler */
-          if(service_cbk) {
+          if(block1_state != 0) {
+            /* intermediate block is acknowledged with 2.31, errors are reported below */
+            if(block1_state > 0
+               && (transaction->packet_len =
+                     coap_serialize_message(response,
+                                            transaction->packet)) == 0) {
+              erbium_status_code = PACKET_SERIALIZATION_ERROR;
+            }
+#if COAP_CACHE
+          } else if(cache_key.len
+                    && coap_cache_lookup(message, response, &cache_key)) {
+            if((transaction->packet_len =
+                  coap_serialize_message(response, transaction->packet)) == 0) {
+              erbium_status_code = PACKET_SERIALIZATION_ERROR;
+            }
+#endif
+#if COAP_PROXY_OPTION_PROCESSING
+          } else if(IS_OPTION(message, COAP_OPTION_PROXY_URI)
+                    || IS_OPTION(message, COAP_OPTION_PROXY_SCHEME)) {
+            if(proxy_cbk == NULL
+               || !proxy_cbk(message, response,
+                             transaction->packet + COAP_MAX_HEADER_SIZE,
+                             block_size, &new_offset)) {
+              erbium_status_code = PROXYING_NOT_SUPPORTED_5_05;
+              coap_error_message = "NoProxy";
+            } else if(erbium_status_code == NO_ERROR
+                      && (transaction->packet_len =
+                            coap_serialize_message(response,
+                                                   transaction->packet)) == 0) {
+              erbium_status_code = PACKET_SERIALIZATION_ERROR;
+            }
+#endif
+          } else if(service_cbk) {
 
             /* call REST framework and check if found and allowed */
             if(service_cbk
@@ -142,6 +233,20 @@ coap_receive(void)
 
                 /* TODO coap_handle_blockwise(request, response, start_offset, end_offset); */
 
+#if COAP_CACHE
+                if(cache_key.len) {
+                  coap_cache_store(response, &cache_key, new_offset);
+                }
+#endif
+
+#if COAP_BLOCK1_REASSEMBLY
+                /* acknowledge the last block of a reassembled upload */
+                if(block1_buffer && !IS_OPTION(response, COAP_OPTION_BLOCK1)) {
+                  coap_set_header_block1(response, message->block1_num, 0,
+                                         message->block1_size);
+                }
+#endif
+
                 /* resource is unaware of Block1 */
                 if(IS_OPTION(message, COAP_OPTION_BLOCK1)
                    && response->code < BAD_REQUEST_4_00
@@ -219,6 +324,9 @@ coap_receive(void)
             erbium_status_code = NOT_IMPLEMENTED_5_01;
             coap_error_message = "NoServiceCallbck"; /* no 'a' to fit into 16 bytes */
           } /* if(service callback) */
+#if COAP_BLOCK1_REASSEMBLY
+          coap_block1_release(block1_buffer);
+#endif
         } else {
           erbium_status_code = SERVICE_UNAVAILABLE_5_03;
           coap_error_message = "NoFreeTraBuffer";
@@ -236,8 +344,7 @@ coap_receive(void)
         } else if(message->type == COAP_TYPE_RST) {
           PRINTF("Received RST\n");
           /* cancel possible subscriptions */
-          coap_remove_observer_by_mid(&UIP_IP_BUF->srcipaddr,
-                                      UIP_UDP_BUF->srcport, message->mid);
+          coap_remove_observer_by_mid(&ctx->addr, ctx->port, message->mid);
         }
 
         if((transaction = coap_get_transaction_by_mid(message->mid))) {
@@ -255,13 +362,20 @@ coap_receive(void)
         /* if(ACKed transaction) */
         transaction = NULL;
 
+#if COAP_ASYNC_CLIENT
+        /* separate response to a request of the asynchronous client */
+        if((message->type == COAP_TYPE_CON || message->type == COAP_TYPE_NON)
+           && !IS_OPTION(message, COAP_OPTION_OBSERVE)) {
+          coap_async_handle_separate(&ctx->addr, ctx->port, message);
+        }
+#endif /* COAP_ASYNC_CLIENT */
+
 #if COAP_OBSERVE_CLIENT
-	/* if observe notification */
+  	/* if observe notification */
         if((message->type == COAP_TYPE_CON || message->type == COAP_TYPE_NON)
               && IS_OPTION(message, COAP_OPTION_OBSERVE)) {
           PRINTF("Observe [%u]\n", message->observe);
-          coap_handle_notification(&UIP_IP_BUF->srcipaddr, UIP_UDP_BUF->srcport,
-              message);
+          coap_handle_notification(&ctx->addr, ctx->port, message);
         }
 #endif /* COAP_OBSERVE_CLIENT */
       } /* request or response */
@@ -293,10 +407,12 @@ coap_receive(void)
                         message->mid);
       coap_set_payload(message, coap_error_message,
                        strlen(coap_error_message));
-      coap_send_message(&UIP_IP_BUF->srcipaddr, UIP_UDP_BUF->srcport,
-                        uip_appdata, coap_serialize_message(message,
-                                                            uip_appdata));
+      coap_send_message(&ctx->addr, ctx->port,
+                        data, coap_serialize_message(message, data));
     }
+
+    current_context = previous;
+    memb_free(&request_contexts_memb, ctx);
   }
 
   /* if(new data) */
@@ -309,12 +425,40 @@ coap_init_engine(void)
   process_start(&coap_engine, NULL);
 }
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief Context of the message currently handled by the engine
+ *
+ *        Resource handlers and callbacks use it to learn the client endpoint
+ *        instead of peeking into the uIP buffer.
+ *
+ * \return The context, NULL when called outside of message handling
+ */
+coap_request_context_t *
+coap_get_request_context(void)
+{
+  return current_context;
+}
+/*---------------------------------------------------------------------------*/
 void
 coap_set_service_callback(service_callback_t callback)
 {
   service_cbk = callback;
 }
 /*---------------------------------------------------------------------------*/
+#if COAP_PROXY_OPTION_PROCESSING
+/**
+ * \brief Set the handler for requests with Proxy-Uri or Proxy-Scheme
+ *
+ *        The callback has the signature of the service callback and returns
+ *        0 for requests it does not proxy, which are answered with 5.05.
+ */
+void
+coap_set_proxy_callback(service_callback_t callback)
+{
+  proxy_cbk = callback;
+}
+#endif
+/*---------------------------------------------------------------------------*/
 rest_resource_flags_t
 coap_get_rest_method(void *packet)
 {
@@ -346,7 +490,9 @@ PROCESS_THREAD(coap_engine, ev, data)
     PROCESS_YIELD();
 
     if(ev == tcpip_event) {
-      coap_receive();
+      if(COAP_TRANSPORT.input) {
+        COAP_TRANSPORT.input();
+      }
     } else if(ev == PROCESS_EVENT_TIMER) {
       /* retransmissions are handled here */
       coap_check_transactions();
@@ -358,78 +504,205 @@ PROCESS_THREAD(coap_engine, ev, data)
 /*---------------------------------------------------------------------------*/
 /*- Client Part -------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/* status of a block request slot */
+enum {
+  BLOCK_FREE,
+  BLOCK_PENDING,
+  BLOCK_RECEIVED,
+  BLOCK_FAILED
+};
+
 void
 coap_blocking_request_callback(void *callback_data, void *response)
 {
-  struct request_state_t *state = (struct request_state_t *)callback_data;
+  struct request_block_t *block = (struct request_block_t *)callback_data;
+  coap_packet_t *packet = (coap_packet_t *)response;
+  uint32_t res_block = 0;
+  uint8_t more = 0;
+  uint16_t size = 0;
+
+  /* the engine already freed the transaction */
+  block->transaction = NULL;
+
+  if(packet == NULL) {
+    PRINTF("Server not responding for #%lu\n", block->num);
+    block->status = BLOCK_FAILED;
+  } else {
+    coap_get_header_block2(packet, &res_block, &more, &size, NULL);
+
+    PRINTF("Received #%lu%s (%u bytes)\n", res_block, more ? "+" : "",
+           packet->payload_len);
+
+    if(res_block != block->num) {
+      PRINTF("WRONG BLOCK %lu/%lu\n", res_block, block->num);
+      block->status = BLOCK_FAILED;
+    } else {
+      /* payload points into the uIP buffer, keep a copy until delivery */
+      block->code = packet->code;
+      block->len = MIN(packet->payload_len, REST_MAX_CHUNK_SIZE);
+      memcpy(block->payload, packet->payload, block->len);
+      /* a first block larger than ours is continued in our block size */
+      block->more = more || block->len < packet->payload_len;
+      if(block->num == 0 && size) {
+        block->state->block_size = MIN(size, REST_MAX_CHUNK_SIZE);
+      }
+      block->status = BLOCK_RECEIVED;
+    }
+  }
+  process_poll(block->state->process);
+}
+/*---------------------------------------------------------------------------*/
+static int
+coap_blocking_request_send(struct request_state_t *state,
+                           struct request_block_t *block, uint32_t num,
+                           uip_ipaddr_t *remote_ipaddr, uint16_t remote_port,
+                           coap_packet_t *request)
+{
+  request->mid = coap_get_mid();
+  if((block->transaction = coap_new_transaction(request->mid, remote_ipaddr,
+                                                remote_port)) == NULL) {
+    return 0;
+  }
+  block->transaction->callback = coap_blocking_request_callback;
+  block->transaction->callback_data = block;
+  block->state = state;
+  block->num = num;
+  block->status = BLOCK_PENDING;
+
+  if(num > 0) {
+    coap_set_header_block2(request, num, 0, state->block_size);
+  }
+  block->transaction->packet_len = coap_serialize_message(request,
+                                                          block->transaction->
+                                                          packet);
 
-  state->response = (coap_packet_t *)response;
-  process_poll(state->process);
+  coap_send_transaction(block->transaction);
+  PRINTF("Requested #%lu (MID %u)\n", num, request->mid);
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
+static void
+coap_blocking_request_release(struct request_block_t *block)
+{
+  if(block->status == BLOCK_PENDING && block->transaction) {
+    coap_clear_transaction(block->transaction);
+  }
+  block->transaction = NULL;
+  block->status = BLOCK_FREE;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Windowed blockwise GET
+ *
+ *        The first block is requested alone to learn the block size and
+ *        whether more blocks follow. Then up to COAP_BLOCKING_REQUEST_WINDOW
+ *        block requests are kept in flight, bounded by free transactions.
+ *        Blocks are handed to request_callback in order; blocks that time
+ *        out or come back with a wrong number are requested again alone,
+ *        until COAP_MAX_ATTEMPTS such errors happened.
+ */
 PT_THREAD(coap_blocking_request
             (struct request_state_t *state, process_event_t ev,
             uip_ipaddr_t *remote_ipaddr, uint16_t remote_port,
             coap_packet_t *request,
             blocking_response_handler request_callback))
 {
-  PT_BEGIN(&state->pt);
+  /* in-order blocks are handed over in this packet */
+  coap_packet_t response[1];
+  struct request_block_t *block;
+  int used;
+  int pending;
+  int i;
 
-  static uint8_t more;
-  static uint32_t res_block;
-  static uint8_t block_error;
+  PT_BEGIN(&state->pt);
 
   state->block_num = 0;
-  state->response = NULL;
+  state->next_num = 0;
+  state->last_num = 0xFFFFFFFF;
+  state->block_size = REST_MAX_CHUNK_SIZE;
+  state->block_error = 0;
   state->process = PROCESS_CURRENT();
-
-  more = 0;
-  res_block = 0;
-  block_error = 0;
+  for(i = 0; i < COAP_BLOCKING_REQUEST_WINDOW; ++i) {
+    state->blocks[i].status = BLOCK_FREE;
+  }
 
   do {
-    request->mid = coap_get_mid();
-    if((state->transaction = coap_new_transaction(request->mid, remote_ipaddr,
-                                                  remote_port))) {
-      state->transaction->callback = coap_blocking_request_callback;
-      state->transaction->callback_data = state;
-
-      if(state->block_num > 0) {
-        coap_set_header_block2(request, state->block_num, 0,
-                               REST_MAX_CHUNK_SIZE);
+    /* retry failed blocks first, then fill the window */
+    used = 0;
+    pending = 0;
+    for(i = 0; i < COAP_BLOCKING_REQUEST_WINDOW; ++i) {
+      block = &state->blocks[i];
+      if(block->status != BLOCK_FREE && block->num > state->last_num) {
+        /* requested before the end was known */
+        coap_blocking_request_release(block);
+      } else if(block->status == BLOCK_FAILED) {
+        if(++(state->block_error) >= COAP_MAX_ATTEMPTS) {
+          PRINTF("Giving up on #%lu\n", block->num);
+          goto done;
+        }
+        if(coap_blocking_request_send(state, block, block->num,
+                                      remote_ipaddr, remote_port, request)) {
+          ++pending;
+        }
+        /* a missing block is retried alone */
+        used = COAP_BLOCKING_REQUEST_WINDOW;
+      } else if(block->status != BLOCK_FREE) {
+        pending += block->status == BLOCK_PENDING;
+        ++used;
       }
-      state->transaction->packet_len = coap_serialize_message(request,
-                                                              state->
-                                                              transaction->
-                                                              packet);
-
-      coap_send_transaction(state->transaction);
-      PRINTF("Requested #%lu (MID %u)\n", state->block_num, request->mid);
-
-      PT_YIELD_UNTIL(&state->pt, ev == PROCESS_EVENT_POLL);
-
-      if(!state->response) {
-        PRINTF("Server not responding\n");
-        PT_EXIT(&state->pt);
+    }
+    /* the first block goes alone to learn the block size */
+    for(i = 0; i < COAP_BLOCKING_REQUEST_WINDOW
+        && used < COAP_BLOCKING_REQUEST_WINDOW
+        && state->next_num <= state->last_num
+        && (state->next_num == 0 || state->block_num > 0); ++i) {
+      block = &state->blocks[i];
+      if(block->status != BLOCK_FREE) {
+        continue;
       }
+      if(!coap_blocking_request_send(state, block, state->next_num,
+                                     remote_ipaddr, remote_port, request)) {
+        /* window is also bounded by the free transactions */
+        break;
+      }
+      ++(state->next_num);
+      ++pending;
+      ++used;
+    }
+    if(pending == 0) {
+      PRINTF("Could not allocate transaction buffer");
+      goto done;
+    }
 
-      coap_get_header_block2(state->response, &res_block, &more, NULL, NULL);
-
-      PRINTF("Received #%lu%s (%u bytes)\n", res_block, more ? "+" : "",
-             state->response->payload_len);
+    PT_YIELD_UNTIL(&state->pt, ev == PROCESS_EVENT_POLL);
 
-      if(res_block == state->block_num) {
-        request_callback(state->response);
-        ++(state->block_num);
-      } else {
-        PRINTF("WRONG BLOCK %lu/%lu\n", res_block, state->block_num);
-        ++block_error;
+    /* deliver received blocks in order */
+    for(i = 0; i < COAP_BLOCKING_REQUEST_WINDOW; ++i) {
+      block = &state->blocks[i];
+      if(block->status != BLOCK_RECEIVED || block->num != state->block_num) {
+        continue;
       }
-    } else {
-      PRINTF("Could not allocate transaction buffer");
-      PT_EXIT(&state->pt);
+      if(!block->more) {
+        state->last_num = block->num;
+      }
+      coap_init_message(response, COAP_TYPE_ACK, block->code, 0);
+      coap_set_header_block2(response, block->num, block->more,
+                             state->block_size);
+      coap_set_payload(response, block->payload, block->len);
+      request_callback(response);
+
+      block->status = BLOCK_FREE;
+      ++(state->block_num);
+      /* start over, the next block may sit in an earlier slot */
+      i = -1;
     }
-  } while(more && block_error < COAP_MAX_ATTEMPTS);
+  } while(state->block_num <= state->last_num);
+
+done:
+  /* drop requests beyond the last block or left over after an error */
+  for(i = 0; i < COAP_BLOCKING_REQUEST_WINDOW; ++i) {
+    coap_blocking_request_release(&state->blocks[i]);
+  }
 
   PT_END(&state->pt);
 }
@@ -44,24 +44,59 @@
 #include "er-coap-transactions.h"
 #include "er-coap-observe.h"
 #include "er-coap-separate.h"
+#include "er-coap-block2.h"
 #include "er-coap-observe-client.h"
+#include "er-coap-client.h"
+#include "er-coap-cache.h"
 
 #define SERVER_LISTEN_PORT      UIP_HTONS(COAP_SERVER_PORT)
 
 typedef coap_packet_t rest_request_t;
 typedef coap_packet_t rest_response_t;
 
+/* everything the engine keeps while one incoming message is handled */
+typedef struct coap_request_context {
+  coap_packet_t message[1];     /* this way the packet can be treated as pointer as usual */
+  coap_packet_t response[1];
+  coap_transaction_t *transaction;
+  uip_ipaddr_t addr;
+  uint16_t port;
+} coap_request_context_t;
+
 void coap_init_engine(void);
+int coap_engine_receive(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
+                        uint16_t len);
+coap_request_context_t *coap_get_request_context(void);
+#if COAP_PROXY_OPTION_PROCESSING
+void coap_set_proxy_callback(service_callback_t callback);
+#endif
 
 /*---------------------------------------------------------------------------*/
 /*- Client Part -------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+struct request_state_t;
+
+/* one block request in flight, the payload is kept until it can be delivered in order */
+struct request_block_t {
+  struct request_state_t *state;
+  coap_transaction_t *transaction;
+  uint32_t num;
+  uint8_t status;
+  uint8_t code;
+  uint8_t more;
+  uint16_t len;
+  uint8_t payload[REST_MAX_CHUNK_SIZE];
+};
+
 struct request_state_t {
   struct pt pt;
   struct process *process;
-  coap_transaction_t *transaction;
-  coap_packet_t *response;
-  uint32_t block_num;
+  uint32_t block_num;           /* next block to deliver */
+  uint32_t next_num;            /* next block to request */
+  uint32_t last_num;            /* last block, known once received */
+  uint16_t block_size;
+  uint8_t block_error;
+  struct request_block_t blocks[COAP_BLOCKING_REQUEST_WINDOW];
 };
 
 typedef void (*blocking_response_handler)(void *response);
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *      CoAP transport over host UDP sockets for the native target
+ *
+ *      Lets the same resources run as a Linux process. Datagrams are read
+ *      with recvmmsg() in batches of COAP_NATIVE_BATCH until the socket is
+ *      drained; replies generated while a batch is handled, notifications,
+ *      and retransmissions are queued and leave with one sendmmsg().
+ *
+ *      The Contiki kernel is single-threaded, so instead of threads the
+ *      transport can fork COAP_NATIVE_WORKERS processes. Each one binds its
+ *      own socket to the CoAP port with SO_REUSEPORT, and the kernel spreads
+ *      the datagrams over the sockets by a hash of the client endpoint. A
+ *      client therefore always talks to the same instance, which keeps its
+ *      own transactions and observers. The workers are forked once every
+ *      process has started and is waiting for an event. A forked worker
+ *      drops the other file descriptors and processes it inherited, so
+ *      only the first instance runs the rest of the application.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE             /* recvmmsg(), sendmmsg() */
+#endif
+
+#include "er-coap-engine.h"
+
+/* Compile this code only for the native target */
+#if CONTIKI_TARGET_NATIVE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#if !NETSTACK_CONF_WITH_IPV6
+#error "coap_native_transport requires IPv6"
+#endif
+
+#define DEBUG 0
+#if DEBUG
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+PROCESS_NAME(coap_engine);
+PROCESS_NAME(rest_engine_process);
+PROCESS_NAME(ctimer_process);
+
+PROCESS(coap_native_process, "CoAP native transport");
+
+static int coap_socket = -1;
+static int worker_id = 0;
+static uint16_t coap_port;
+
+/* received datagrams, also reused for error replies */
+static uint8_t rx_buf[COAP_NATIVE_BATCH][UIP_BUFSIZE];
+static struct sockaddr_in6 rx_addr[COAP_NATIVE_BATCH];
+static struct iovec rx_iov[COAP_NATIVE_BATCH];
+static struct mmsghdr rx_msg[COAP_NATIVE_BATCH];
+
+/* replies queued while a batch is handled */
+static uint8_t tx_buf[COAP_NATIVE_BATCH][UIP_BUFSIZE];
+static struct sockaddr_in6 tx_addr[COAP_NATIVE_BATCH];
+static struct iovec tx_iov[COAP_NATIVE_BATCH];
+static struct mmsghdr tx_msg[COAP_NATIVE_BATCH];
+static int tx_len = 0;
+static int tx_batching = 0;             /* nesting depth of open batches */
+
+/*---------------------------------------------------------------------------*/
+static void
+flush(void)
+{
+  int i;
+  int sent;
+
+  for(i = 0; i < tx_len; i += sent) {
+    if((sent = sendmmsg(coap_socket, &tx_msg[i], tx_len - i, 0)) <= 0) {
+      PRINTF("CoAP worker %d: sendmmsg failed (%d)\n", worker_id, errno);
+      break;
+    }
+  }
+  tx_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  FD_SET(coap_socket, rset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  uip_ipaddr_t addr;
+  int n;
+  int i;
+
+  if(!FD_ISSET(coap_socket, rset)) {
+    return;
+  }
+
+  /* timers started while handling belong to the engine */
+  PROCESS_CONTEXT_BEGIN(&coap_engine);
+  ++tx_batching;
+  do {
+    for(i = 0; i < COAP_NATIVE_BATCH; ++i) {
+      rx_msg[i].msg_hdr.msg_namelen = sizeof(rx_addr[i]);
+    }
+    n = recvmmsg(coap_socket, rx_msg, COAP_NATIVE_BATCH, MSG_DONTWAIT, NULL);
+    PRINTF("CoAP worker %d: batch of %d\n", worker_id, n);
+
+    for(i = 0; i < n; ++i) {
+      memcpy(&addr, &rx_addr[i].sin6_addr, sizeof(addr));
+      coap_engine_receive(&addr, rx_addr[i].sin6_port, rx_buf[i],
+                          (uint16_t)rx_msg[i].msg_len);
+    }
+    flush();
+  } while(n == COAP_NATIVE_BATCH);
+  --tx_batching;
+  PROCESS_CONTEXT_END(&coap_engine);
+}
+/*---------------------------------------------------------------------------*/
+static const struct select_callback coap_select_callback = {
+  set_fd, handle_fd
+};
+/*---------------------------------------------------------------------------*/
+/*
+ * A forked worker starts as a copy of the whole instance. Keep the timers
+ * and the CoAP and REST engines, and stop listening on the inherited
+ * descriptors (tun, serial line, stdin) and running the other processes.
+ * This runs for a posted event, so every other process is waiting at a
+ * yield and gets its PROCESS_EVENT_EXIT there.
+ */
+static void
+restrict_worker(void)
+{
+  struct process *p;
+  int fd;
+
+  for(fd = 0; fd < FD_SETSIZE; ++fd) {
+    select_set_callback(fd, NULL);
+  }
+
+  p = process_list;
+  while(p != NULL) {
+    if(p == PROCESS_CURRENT()
+       || p == &coap_engine || p == &rest_engine_process
+       || p == &etimer_process || p == &ctimer_process) {
+      p = p->next;
+    } else {
+      /* exiting may change the list, start over */
+      process_exit(p);
+      p = process_list;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+open_socket(uint16_t port)
+{
+  struct sockaddr_in6 sa;
+  int on = 1;
+  int i;
+
+  /* every worker needs its own socket to get its own share */
+  if((coap_socket = socket(AF_INET6, SOCK_DGRAM, 0)) < 0) {
+    perror("coap-native: socket");
+    return;
+  }
+  if(setsockopt(coap_socket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+    perror("coap-native: SO_REUSEPORT");
+  }
+  memset(&sa, 0, sizeof(sa));
+  sa.sin6_family = AF_INET6;
+  sa.sin6_addr = in6addr_any;
+  sa.sin6_port = port;
+  if(bind(coap_socket, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+    perror("coap-native: bind");
+    close(coap_socket);
+    coap_socket = -1;
+    return;
+  }
+  fcntl(coap_socket, F_SETFL, fcntl(coap_socket, F_GETFL) | O_NONBLOCK);
+
+  for(i = 0; i < COAP_NATIVE_BATCH; ++i) {
+    rx_iov[i].iov_base = rx_buf[i];
+    rx_iov[i].iov_len = sizeof(rx_buf[i]);
+    rx_msg[i].msg_hdr.msg_name = &rx_addr[i];
+    rx_msg[i].msg_hdr.msg_iov = &rx_iov[i];
+    rx_msg[i].msg_hdr.msg_iovlen = 1;
+
+    tx_iov[i].iov_base = tx_buf[i];
+    tx_msg[i].msg_hdr.msg_name = &tx_addr[i];
+    tx_msg[i].msg_hdr.msg_namelen = sizeof(tx_addr[i]);
+    tx_msg[i].msg_hdr.msg_iov = &tx_iov[i];
+    tx_msg[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  select_set_callback(coap_socket, &coap_select_callback);
+  PRINTF("CoAP worker %d (pid %d) listening on port %u\n", worker_id,
+         (int)getpid(), uip_ntohs(port));
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The engine initializes the transport while the application is still
+ * starting it (from rest_init_engine()), so the workers are only forked
+ * for the event this process posts itself. Until then nothing is sent.
+ */
+PROCESS_THREAD(coap_native_process, ev, data)
+{
+  int i;
+  pid_t pid;
+
+  PROCESS_BEGIN();
+
+  PROCESS_PAUSE();
+
+  /* nothing has been received yet, the workers start without observers */
+  for(i = 1; i < COAP_NATIVE_WORKERS; ++i) {
+    if((pid = fork()) == 0) {
+      worker_id = i;
+      restrict_worker();
+      break;
+    } else if(pid < 0) {
+      perror("coap-native: fork");
+      break;
+    }
+  }
+  open_socket(coap_port);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+static void
+transport_init(uint16_t port)
+{
+  coap_port = port;
+  process_start(&coap_native_process, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+transport_send(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
+               uint16_t length)
+{
+  struct sockaddr_in6 *sa;
+
+  if(coap_socket < 0 || length > UIP_BUFSIZE) {
+    return;
+  }
+
+  /* the caller may reuse data, e.g., a freed transaction buffer */
+  sa = &tx_addr[tx_len];
+  memset(sa, 0, sizeof(*sa));
+  sa->sin6_family = AF_INET6;
+  memcpy(&sa->sin6_addr, addr, sizeof(sa->sin6_addr));
+  sa->sin6_port = port;
+  memcpy(tx_buf[tx_len], data, length);
+  tx_iov[tx_len].iov_len = length;
+  ++tx_len;
+
+  /* outside of a batch (e.g., client requests) send right away */
+  if(!tx_batching || tx_len == COAP_NATIVE_BATCH) {
+    flush();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+transport_batch(int begin)
+{
+  if(begin) {
+    ++tx_batching;
+  } else if(tx_batching > 0 && --tx_batching == 0) {
+    flush();
+  }
+}
+/*---------------------------------------------------------------------------*/
+const struct coap_transport_driver coap_native_transport = {
+  "native",
+  transport_init,
+  NULL,
+  transport_send,
+  transport_batch,
+};
+/*---------------------------------------------------------------------------*/
+#endif /* CONTIKI_TARGET_NATIVE */
@@ -194,7 +194,7 @@ static void
 simple_reply(coap_message_type_t type, uip_ip6addr_t *addr, uint16_t port,
              coap_packet_t *notification)
 {
-  static coap_packet_t response[1];
+  coap_packet_t response[1];
   size_t len;
 
   coap_init_message(response, type, NO_ERROR, notification->mid);
@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "er-coap-observe.h"
+#include "er-coap-engine.h"
 
 #define DEBUG 0
 #if DEBUG
@@ -58,6 +59,12 @@ LIST(observers_list);
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+list_t
+coap_get_observers(void)
+{
+  return observers_list;
+}
+/*---------------------------------------------------------------------------*/
 coap_observer_t *
 coap_add_observer(uip_ipaddr_t *addr, uint16_t port, const uint8_t *token,
                   size_t token_len, const char *uri)
@@ -175,20 +182,30 @@ coap_remove_observer_by_mid(uip_ipaddr_t *addr, uint16_t port, uint16_t mid)
 /*---------------------------------------------------------------------------*/
 /*- Notification ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
-void
-coap_notify_observers(resource_t *resource)
+/*
+ * The representation is either generated by the resource handler or copied
+ * from a packet received from another server; it is built once and shared by
+ * all observers of url.
+ */
+static void
+notify_observers(const char *url, resource_t *resource,
+                 coap_packet_t *representation)
 {
   /* build notification */
   coap_packet_t notification[1]; /* this way the packet can be treated as pointer as usual */
+  static uint8_t payload[REST_MAX_CHUNK_SIZE];
+  uint8_t generated = 0;
   coap_init_message(notification, COAP_TYPE_NON, CONTENT_2_05, 0);
   coap_observer_t *obs = NULL;
 
-  PRINTF("Observe: Notification from %s\n", resource->url);
+  PRINTF("Observe: Notification from %s\n", url);
+
+  coap_batch_begin();
 
   /* iterate over observers */
   for(obs = (coap_observer_t *)list_head(observers_list); obs;
       obs = obs->next) {
-    if(obs->url == resource->url) {     /* using RESOURCE url pointer as handle */
+    if(obs->url == url) {     /* using RESOURCE url pointer as handle */
       coap_transaction_t *transaction = NULL;
 
       /*TODO implement special transaction for CON, sharing the same buffer to allow for more observers */
@@ -209,9 +226,24 @@ coap_notify_observers(resource_t *resource)
         /* prepare response */
         notification->mid = transaction->mid;
 
-        resource->get_handler(NULL, notification,
-                              transaction->packet + COAP_MAX_HEADER_SIZE,
-                              REST_MAX_CHUNK_SIZE, NULL);
+        if(!generated) {
+          if(resource) {
+            resource->get_handler(NULL, notification, payload,
+                                  REST_MAX_CHUNK_SIZE, NULL);
+          } else {
+            coap_set_status_code(notification, representation->code);
+            if(IS_OPTION(representation, COAP_OPTION_CONTENT_FORMAT)) {
+              coap_set_header_content_format(notification,
+                                             representation->content_format);
+            }
+            if(IS_OPTION(representation, COAP_OPTION_MAX_AGE)) {
+              coap_set_header_max_age(notification, representation->max_age);
+            }
+            coap_set_payload(notification, representation->payload,
+                             representation->payload_len);
+          }
+          generated = 1;
+        }
 
         if(notification->code < BAD_REQUEST_4_00) {
           coap_set_header_observe(notification, (obs->obs_counter)++);
@@ -225,6 +257,30 @@ coap_notify_observers(resource_t *resource)
       }
     }
   }
+
+  coap_batch_end();
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_notify_observers(resource_t *resource)
+{
+  notify_observers(resource->url, resource, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Notify observers that were added with a url handle of their own
+ *
+ *        Used to re-publish a representation obtained from another server,
+ *        e.g., the notifications of an observation relayed by a proxy. An
+ *        error code ends the observation for the clients.
+ *
+ * \param url             Handle given to coap_add_observer()
+ * \param representation  Code, Content-Format, Max-Age, and payload to send
+ */
+void
+coap_notify_observers_of(const char *url, coap_packet_t *representation)
+{
+  notify_observers(url, NULL, representation);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -232,6 +288,7 @@ coap_observe_handler(resource_t *resource, void *request, void *response)
 {
   coap_packet_t *const coap_req = (coap_packet_t *)request;
   coap_packet_t *const coap_res = (coap_packet_t *)response;
+  coap_request_context_t *const ctx = coap_get_request_context();
   coap_observer_t * obs;
 
   static char content[16];
@@ -239,7 +296,7 @@ coap_observe_handler(resource_t *resource, void *request, void *response)
   if(coap_req->code == COAP_GET && coap_res->code < 128) { /* GET request and response without error code */
     if(IS_OPTION(coap_req, COAP_OPTION_OBSERVE)) {
       if(coap_req->observe == 0) {
-        obs = coap_add_observer(&UIP_IP_BUF->srcipaddr, UIP_UDP_BUF->srcport,
+        obs = coap_add_observer(&ctx->addr, ctx->port,
                                 coap_req->token, coap_req->token_len,
                                 resource->url);
        if(obs) {
@@ -263,9 +320,8 @@ coap_observe_handler(resource_t *resource, void *request, void *response)
       } else if(coap_req->observe == 1) {
 
         /* remove client if it is currently observe */
-        coap_remove_observer_by_token(&UIP_IP_BUF->srcipaddr,
-                                      UIP_UDP_BUF->srcport, coap_req->token,
-                                      coap_req->token_len);
+        coap_remove_observer_by_token(&ctx->addr, ctx->port,
+                                      coap_req->token, coap_req->token_len);
       }
     }
   }
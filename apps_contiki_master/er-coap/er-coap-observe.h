@@ -83,6 +83,7 @@ int coap_remove_observer_by_mid(uip_ipaddr_t *addr, uint16_t port,
                                 uint16_t mid);
 
 void coap_notify_observers(resource_t *resource);
+void coap_notify_observers_of(const char *url, coap_packet_t *representation);
 
 void coap_observe_handler(resource_t *resource, void *request,
                           void *response);
@@ -73,6 +73,8 @@
   } \
   strpos += tmplen
 
+extern resource_t res_well_known_core;
+
 /*---------------------------------------------------------------------------*/
 /*- Resource Handlers -------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -83,7 +85,9 @@ well_known_core_get_handler(void *request, void *response, uint8_t *buffer,
   size_t strpos = 0;            /* position in overall string (which is larger than the buffer) */
   size_t bufpos = 0;            /* position within buffer (bytes written) */
   size_t tmplen = 0;
+  size_t res_start = 0;         /* strpos at the start of the current resource */
   resource_t *resource = NULL;
+  const void *cursor = NULL;
 
 #if COAP_LINK_FORMAT_FILTERING
   /* For filtering. */
@@ -113,8 +117,15 @@ well_known_core_get_handler(void *request, void *response, uint8_t *buffer,
   }
 #endif
 
-  for(resource = (resource_t *)list_head(rest_get_resources()); resource;
-      resource = resource->next) {
+  /* continue at the resource where the previous block of this client stopped */
+  if(*offset > 0
+     && coap_block2_resume(&res_well_known_core, *offset, &cursor, &strpos)) {
+    resource = (resource_t *)cursor;
+  } else {
+    resource = (resource_t *)list_head(rest_get_resources());
+  }
+
+  for(; resource; resource = resource->next) {
 #if COAP_LINK_FORMAT_FILTERING
     /* Filtering */
     if(len) {
@@ -162,6 +173,8 @@ well_known_core_get_handler(void *request, void *response, uint8_t *buffer,
     PRINTF("res: /%s (%p)\npos: s%d, o%ld, b%d\n", resource->url, resource,
            strpos, *offset, bufpos);
 
+    res_start = strpos;
+
     if(strpos > 0) {
       ADD_CHAR_IF_POSSIBLE(',');
     }
@@ -197,9 +210,11 @@ well_known_core_get_handler(void *request, void *response, uint8_t *buffer,
   if(resource == NULL) {
     PRINTF("res: DONE\n");
     *offset = -1;
+    coap_block2_discard(&res_well_known_core);
   } else {
     PRINTF("res: MORE at %s (%p)\n", resource->url, resource);
     *offset += preferred_size;
+    coap_block2_suspend(&res_well_known_core, *offset, resource, res_start);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -54,6 +54,9 @@
 #define PRINTLLADDR(addr)
 #endif
 
+MEMB(separate_waiters_memb, coap_separate_waiter_t, COAP_MAX_SEPARATE_WAITERS);
+LIST(separate_waiters_list);
+
 /*---------------------------------------------------------------------------*/
 /*- Separate Response API ---------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -100,7 +103,7 @@ coap_separate_accept(void *request, coap_separate_t *separate_store)
       /* ACK with empty code (0) */
       coap_init_message(ack, COAP_TYPE_ACK, 0, coap_req->mid);
       /* serializing into IPBUF: Only overwrites header parts that are already parsed into the request struct */
-      coap_send_message(&UIP_IP_BUF->srcipaddr, UIP_UDP_BUF->srcport,
+      coap_send_message(&t->addr, t->port,
                         (uip_appdata), coap_serialize_message(ack,
                                                               uip_appdata));
     }
@@ -131,6 +134,38 @@ coap_separate_accept(void *request, coap_separate_t *separate_store)
   }
 }
 /*----------------------------------------------------------------------------*/
+/**
+ * \brief Acknowledge a request that is answered by other means later
+ * \param request The request to acknowledge
+ *
+ * Unlike coap_separate_accept(), nothing is stored for a response, e.g.,
+ * for an observe registration that the first notification answers. A CON
+ * request gets an empty ACK, and the engine sends no response.
+ */
+void
+coap_separate_ack(void *request)
+{
+  coap_packet_t *const coap_req = (coap_packet_t *)request;
+  coap_transaction_t *const t = coap_get_transaction_by_mid(coap_req->mid);
+
+  PRINTF("Separate ACK: /%.*s MID %u\n", coap_req->uri_path_len,
+         coap_req->uri_path, coap_req->mid);
+  if(t) {
+    if(coap_req->type == COAP_TYPE_CON) {
+      coap_packet_t ack[1];
+
+      /* ACK with empty code (0) */
+      coap_init_message(ack, COAP_TYPE_ACK, 0, coap_req->mid);
+      coap_send_message(&t->addr, t->port, uip_appdata,
+                        coap_serialize_message(ack, uip_appdata));
+    }
+    erbium_status_code = MANUAL_RESPONSE;
+  } else {
+    PRINTF("ERROR: Response transaction for separate request not found!\n");
+    erbium_status_code = INTERNAL_SERVER_ERROR_5_00;
+  }
+}
+/*----------------------------------------------------------------------------*/
 void
 coap_separate_resume(void *response, coap_separate_t *separate_store,
                      uint8_t code)
@@ -147,3 +182,145 @@ coap_separate_resume(void *response, coap_separate_t *separate_store,
   }
 }
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief Accept a request into the pooled queue of an operation
+ * \param key The operation the request waits for, e.g., a sensor or resource
+ * \param request The request to accept
+ *
+ * Several requests can wait for the same key and are all answered by one
+ * coap_separate_drain(). When the pool is full, the request is rejected
+ * with 5.03 like with coap_separate_reject().
+ *
+ * \return 1 if the request is queued, 0 if it was rejected
+ */
+int
+coap_separate_queue(const void *key, void *request)
+{
+  coap_separate_waiter_t *w = memb_alloc(&separate_waiters_memb);
+
+  if(w == NULL) {
+    PRINTF("Separate QUEUE: no free waiter\n");
+    coap_separate_reject();
+    return 0;
+  }
+
+  coap_separate_accept(request, &w->store);
+  if(erbium_status_code != MANUAL_RESPONSE) {
+    memb_free(&separate_waiters_memb, w);
+    return 0;
+  }
+
+  w->key = key;
+  list_add(separate_waiters_list, w);
+  return 1;
+}
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Number of requests waiting for an operation
+ */
+int
+coap_separate_waiting(const void *key)
+{
+  coap_separate_waiter_t *w = NULL;
+  int count = 0;
+
+  for(w = (coap_separate_waiter_t *)list_head(separate_waiters_list); w;
+      w = w->next) {
+    if(w->key == key) {
+      ++count;
+    }
+  }
+  return count;
+}
+/*----------------------------------------------------------------------------*/
+/* options are left out when content_format/max_age are -1 or etag_len is 0 */
+static int
+drain(const void *key, uint8_t code, int content_format, int32_t max_age,
+      const uint8_t *etag, size_t etag_len, const void *payload,
+      size_t length)
+{
+  coap_separate_waiter_t *w = NULL;
+  coap_separate_waiter_t *next = NULL;
+  coap_transaction_t *t = NULL;
+  coap_packet_t response[1];
+  int answered = 0;
+
+  coap_batch_begin();
+  for(w = (coap_separate_waiter_t *)list_head(separate_waiters_list); w;
+      w = next) {
+    next = w->next;
+    if(w->key != key) {
+      continue;
+    }
+
+    if((t = coap_new_transaction(w->store.mid, &w->store.addr,
+                                 w->store.port))) {
+      coap_separate_resume(response, &w->store, code);
+      if(content_format >= 0) {
+        coap_set_header_content_format(response, content_format);
+      }
+      if(max_age >= 0) {
+        coap_set_header_max_age(response, max_age);
+      }
+      if(etag_len) {
+        coap_set_header_etag(response, etag, etag_len);
+      }
+      coap_set_payload(response, payload, length);
+      t->packet_len = coap_serialize_message(response, t->packet);
+      coap_send_transaction(t);
+      ++answered;
+    } else {
+      PRINTF("Separate DRAIN: no transaction for MID %u\n", w->store.mid);
+    }
+
+    list_remove(separate_waiters_list, w);
+    memb_free(&separate_waiters_memb, w);
+  }
+  coap_batch_end();
+
+  return answered;
+}
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Answer all requests waiting for an operation with one result
+ * \param key The operation that completed
+ * \param code Response code, an error code also serves to give up waiting
+ * \param content_format Content-Format of the payload
+ * \param payload The result, at most REST_MAX_CHUNK_SIZE bytes are sent
+ * \param length Length of the payload
+ *
+ * Waiters are removed from the queue even when no transaction is free for
+ * their response; their clients will retry.
+ *
+ * \return Number of responses sent
+ */
+int
+coap_separate_drain(const void *key, uint8_t code, unsigned int content_format,
+                    const void *payload, size_t length)
+{
+  return drain(key, code, content_format, -1, NULL, 0, payload, length);
+}
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Answer all requests waiting for an operation with a received response
+ * \param key The operation that completed
+ * \param result Response of another server, e.g., for a proxied request
+ *
+ * Like coap_separate_drain(), but code, Content-Format, Max-Age, ETag, and
+ * payload are copied from the given response.
+ *
+ * \return Number of responses sent
+ */
+int
+coap_separate_forward(const void *key, coap_packet_t *result)
+{
+  int content_format = IS_OPTION(result, COAP_OPTION_CONTENT_FORMAT)
+    ? (int)result->content_format : -1;
+  int32_t max_age = IS_OPTION(result, COAP_OPTION_MAX_AGE)
+    ? (int32_t)result->max_age : -1;
+  size_t etag_len = IS_OPTION(result, COAP_OPTION_ETAG) ? result->etag_len : 0;
+
+  return drain(key, result->code, content_format, max_age, result->etag,
+               etag_len, result->payload, result->payload_len);
+}
+/*----------------------------------------------------------------------------*/
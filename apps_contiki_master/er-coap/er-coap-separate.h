@@ -59,11 +59,26 @@ typedef struct coap_separate {
   uint16_t block2_size;
 } coap_separate_t;
 
+/* request queued until the result of a slow operation is available */
+typedef struct coap_separate_waiter {
+  struct coap_separate_waiter *next;    /* for LIST */
+  const void *key;                      /* operation the request waits for */
+  coap_separate_t store;
+} coap_separate_waiter_t;
+
 int coap_separate_handler(resource_t *resource, void *request,
                           void *response);
 void coap_separate_reject();
 void coap_separate_accept(void *request, coap_separate_t *separate_store);
+void coap_separate_ack(void *request);
 void coap_separate_resume(void *response, coap_separate_t *separate_store,
                           uint8_t code);
 
+int coap_separate_queue(const void *key, void *request);
+int coap_separate_waiting(const void *key);
+int coap_separate_drain(const void *key, uint8_t code,
+                        unsigned int content_format, const void *payload,
+                        size_t length);
+int coap_separate_forward(const void *key, coap_packet_t *result);
+
 #endif /* COAP_SEPARATE_H_ */
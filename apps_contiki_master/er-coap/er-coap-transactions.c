@@ -174,6 +174,7 @@ coap_check_transactions()
 {
   coap_transaction_t *t = NULL;
 
+  coap_batch_begin();
   for(t = (coap_transaction_t *)list_head(transactions_list); t; t = t->next) {
     if(etimer_expired(&t->retrans_timer)) {
       ++(t->retrans_counter);
@@ -181,5 +182,6 @@ coap_check_transactions()
       coap_send_transaction(t);
     }
   }
+  coap_batch_end();
 }
 /*---------------------------------------------------------------------------*/
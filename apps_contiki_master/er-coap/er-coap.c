@@ -60,7 +60,6 @@
 /*---------------------------------------------------------------------------*/
 /*- Variables ---------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
-static struct uip_udp_conn *udp_conn = NULL;
 static uint16_t current_mid = 0;
 
 coap_status_t erbium_status_code = NO_ERROR;
@@ -276,10 +275,8 @@ coap_get_variable(const char *buffer, size_t length, const char *name,
 void
 coap_init_connection(uint16_t port)
 {
-  /* new connection with remote host */
-  udp_conn = udp_new(NULL, 0, NULL);
-  udp_bind(udp_conn, port);
-  PRINTF("Listening on port %u\n", uip_ntohs(udp_conn->lport));
+  PRINTF("CoAP transport: %s\n", COAP_TRANSPORT.name);
+  COAP_TRANSPORT.init(port);
 
   /* initialize transaction ID */
   current_mid = random_rand();
@@ -422,17 +419,32 @@ void
 coap_send_message(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
                   uint16_t length)
 {
-  /* configure connection to reply to client */
-  uip_ipaddr_copy(&udp_conn->ripaddr, addr);
-  udp_conn->rport = port;
-
-  uip_udp_packet_send(udp_conn, data, length);
+  COAP_TRANSPORT.send(addr, port, data, length);
 
   PRINTF("-sent UDP datagram (%u)-\n", length);
-
-  /* restore server socket to allow data from any node */
-  memset(&udp_conn->ripaddr, 0, sizeof(udp_conn->ripaddr));
-  udp_conn->rport = 0;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Coalesce the following sends until coap_batch_end()
+ *
+ *        Used around bursts such as notification fan-out and retransmissions,
+ *        so that transports which support it hand them to the host at once.
+ *        Calls can be nested.
+ */
+void
+coap_batch_begin(void)
+{
+  if(COAP_TRANSPORT.batch) {
+    COAP_TRANSPORT.batch(1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_batch_end(void)
+{
+  if(COAP_TRANSPORT.batch) {
+    COAP_TRANSPORT.batch(0);
+  }
 }
 /*---------------------------------------------------------------------------*/
 coap_status_t
@@ -566,23 +578,30 @@ coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
 
     case COAP_OPTION_PROXY_URI:
 #if COAP_PROXY_OPTION_PROCESSING
+      /* the engine passes the request to the proxy callback */
       coap_pkt->proxy_uri = (char *)current_option;
       coap_pkt->proxy_uri_len = option_length;
-#endif
-      PRINTF("Proxy-Uri NOT IMPLEMENTED [%.*s]\n", coap_pkt->proxy_uri_len,
+      PRINTF("Proxy-Uri [%.*s]\n", coap_pkt->proxy_uri_len,
              coap_pkt->proxy_uri);
+#else
+      PRINTF("Proxy-Uri NOT IMPLEMENTED [%.*s]\n", option_length,
+             current_option);
       coap_error_message = "This is a constrained server (Contiki)";
       return PROXYING_NOT_SUPPORTED_5_05;
+#endif
       break;
     case COAP_OPTION_PROXY_SCHEME:
 #if COAP_PROXY_OPTION_PROCESSING
       coap_pkt->proxy_scheme = (char *)current_option;
       coap_pkt->proxy_scheme_len = option_length;
-#endif
-      PRINTF("Proxy-Scheme NOT IMPLEMENTED [%.*s]\n",
-             coap_pkt->proxy_scheme_len, coap_pkt->proxy_scheme);
+      PRINTF("Proxy-Scheme [%.*s]\n", coap_pkt->proxy_scheme_len,
+             coap_pkt->proxy_scheme);
+#else
+      PRINTF("Proxy-Scheme NOT IMPLEMENTED [%.*s]\n", option_length,
+             current_option);
       coap_error_message = "This is a constrained server (Contiki)";
       return PROXYING_NOT_SUPPORTED_5_05;
+#endif
       break;
 
     case COAP_OPTION_URI_HOST:
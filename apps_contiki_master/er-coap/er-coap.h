@@ -176,6 +176,26 @@ typedef struct {
     current_number = number; \
   }
 
+/* transport the engine exchanges CoAP datagrams through */
+struct coap_transport_driver {
+  char *name;
+
+  /* open the CoAP endpoint, port in network byte order */
+  void (*init)(uint16_t port);
+
+  /* hand pending datagrams to coap_engine_receive(), called on tcpip_event */
+  void (*input)(void);
+
+  /* send one datagram, data may be reused once the call returns */
+  void (*send)(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
+               uint16_t length);
+
+  /* optional: hold sends while begin is set, flush them when it is cleared */
+  void (*batch)(int begin);
+};
+
+extern const struct coap_transport_driver COAP_TRANSPORT;
+
 /* to store error code and human-readable payload */
 extern coap_status_t erbium_status_code;
 extern char *coap_error_message;
@@ -188,6 +208,8 @@ void coap_init_message(void *packet, coap_message_type_t type, uint8_t code,
 size_t coap_serialize_message(void *packet, uint8_t *buffer);
 void coap_send_message(uip_ipaddr_t *addr, uint16_t port, uint8_t *data,
                        uint16_t length);
+void coap_batch_begin(void);
+void coap_batch_end(void);
 coap_status_t coap_parse_message(void *request, uint8_t *data,
                                  uint16_t data_len);
 
@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      IPv6/UDP header compression on the SLIP link to the host
+ */
+
+#include "slip-iphc.h"
+#include <string.h>
+
+#define IPHC_DISPATCH      0x60
+#define IPHC_DISPATCH_MASK 0xe0
+/* first byte */
+#define IPHC_TF_MASK       0x18
+#define IPHC_TF_TC         0x10   /* ECN + DSCP inline, no flow label */
+#define IPHC_TF_ELIDED     0x18
+#define IPHC_NH            0x04   /* next header compressed with NHC */
+#define IPHC_HLIM_MASK     0x03
+#define IPHC_HLIM_1        0x01
+#define IPHC_HLIM_64       0x02
+#define IPHC_HLIM_255      0x03
+/* second byte, one address mode each: source <<4, destination <<0 */
+#define IPHC_CID           0x80
+#define IPHC_SRC_SHIFT     4
+#define IPHC_M             0x08   /* multicast (destination) */
+#define IPHC_AC            0x04   /* context based (SAC/DAC) */
+#define IPHC_AM_MASK       0x03
+#define IPHC_AM_128        0x00
+#define IPHC_AM_64         0x01
+#define IPHC_AM_16         0x02
+#define IPHC_AM_MCAST_8    0x03   /* ff02::00XX */
+
+#define NHC_UDP            0xf0
+#define NHC_UDP_MASK       0xf8
+#define NHC_UDP_PORTS_MASK 0x03
+#define NHC_UDP_PORTS_16   0x00
+#define NHC_UDP_DST_8      0x01
+#define NHC_UDP_SRC_8      0x02
+#define NHC_UDP_PORTS_4    0x03
+#define NHC_UDP_PORT_8     0xf000
+#define NHC_UDP_PORT_4     0xf0b0
+
+#define IPH_LEN  40
+#define UDPH_LEN 8
+
+static const uint8_t link_local[8] = { 0xfe, 0x80 };
+static uint8_t context[8];
+static uint8_t context_set;
+/*---------------------------------------------------------------------------*/
+void
+slip_iphc_set_context(const uip_ipaddr_t *prefix)
+{
+  memcpy(context, prefix, sizeof(context));
+  context_set = 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+slip_iphc_is_compressed(const uint8_t *packet)
+{
+  return (packet[0] & IPHC_DISPATCH_MASK) == IPHC_DISPATCH
+    && (packet[0] & IPHC_TF_TC);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Append the inline part of a unicast address, return its mode
+ */
+static uint8_t
+compress_addr(const uint8_t *addr, uint8_t **out, int source)
+{
+  static const uint8_t iid_16[6] = { 0, 0, 0, 0xff, 0xfe, 0 };
+  uint8_t mode;
+
+  if(source && uip_is_addr_unspecified((const uip_ipaddr_t *)addr)) {
+    return IPHC_AC | IPHC_AM_128;
+  }
+  if(memcmp(addr, link_local, 8) == 0) {
+    mode = 0;
+  } else if(context_set && memcmp(addr, context, 8) == 0) {
+    mode = IPHC_AC;
+  } else {
+    memcpy(*out, addr, 16);
+    *out += 16;
+    return IPHC_AM_128;
+  }
+
+  if(memcmp(&addr[8], iid_16, 6) == 0) {
+    memcpy(*out, &addr[14], 2);
+    *out += 2;
+    return mode | IPHC_AM_16;
+  }
+  memcpy(*out, &addr[8], 8);
+  *out += 8;
+  return mode | IPHC_AM_64;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+compress_dest(const uint8_t *addr, uint8_t **out)
+{
+  static const uint8_t zero[13];
+
+  if(addr[0] != 0xff) {
+    return compress_addr(addr, out, 0);
+  }
+  if(addr[1] == 0x02 && memcmp(&addr[2], zero, sizeof(zero)) == 0) {
+    *(*out)++ = addr[15];
+    return IPHC_M | IPHC_AM_MCAST_8;
+  }
+  memcpy(*out, addr, 16);
+  *out += 16;
+  return IPHC_M | IPHC_AM_128;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+slip_iphc_compress(const uint8_t *packet, uint16_t len,
+                   uint8_t *hdr, uint8_t *hdr_len)
+{
+  const struct uip_ip_hdr *ip = (const struct uip_ip_hdr *)packet;
+  const struct uip_udp_hdr *udp;
+  uint8_t *out = hdr + 2;
+  uint8_t tc, *nhc;
+  uint16_t src, dst;
+
+  if(len < IPH_LEN || (ip->vtc & 0xf0) != 0x60
+     || (ip->tcflow & 0x0f) != 0 || ip->flow != 0) {
+    return 0;
+  }
+
+  hdr[0] = IPHC_DISPATCH;
+  tc = (ip->vtc << 4) | (ip->tcflow >> 4);
+  if(tc == 0) {
+    hdr[0] |= IPHC_TF_ELIDED;
+  } else {
+    /* ECN before DSCP */
+    hdr[0] |= IPHC_TF_TC;
+    *out++ = (tc << 6) | (tc >> 2);
+  }
+
+  if(ip->proto == UIP_PROTO_UDP && len >= IPH_LEN + UDPH_LEN) {
+    hdr[0] |= IPHC_NH;
+  } else {
+    *out++ = ip->proto;
+  }
+
+  switch(ip->ttl) {
+  case 1:
+    hdr[0] |= IPHC_HLIM_1;
+    break;
+  case 64:
+    hdr[0] |= IPHC_HLIM_64;
+    break;
+  case 255:
+    hdr[0] |= IPHC_HLIM_255;
+    break;
+  default:
+    *out++ = ip->ttl;
+  }
+
+  hdr[1] = compress_addr(ip->srcipaddr.u8, &out, 1) << IPHC_SRC_SHIFT;
+  hdr[1] |= compress_dest(ip->destipaddr.u8, &out);
+
+  if(!(hdr[0] & IPHC_NH)) {
+    *hdr_len = out - hdr;
+    return IPH_LEN;
+  }
+
+  /* UDP: the length is elided, the checksum is kept */
+  udp = (const struct uip_udp_hdr *)&packet[IPH_LEN];
+  src = uip_ntohs(udp->srcport);
+  dst = uip_ntohs(udp->destport);
+  nhc = out++;
+  *nhc = NHC_UDP;
+  if((src & 0xfff0) == NHC_UDP_PORT_4 && (dst & 0xfff0) == NHC_UDP_PORT_4) {
+    *nhc |= NHC_UDP_PORTS_4;
+    *out++ = ((src & 0x0f) << 4) | (dst & 0x0f);
+  } else if((dst & 0xff00) == NHC_UDP_PORT_8) {
+    *nhc |= NHC_UDP_DST_8;
+    memcpy(out, &udp->srcport, 2);
+    out += 2;
+    *out++ = dst & 0xff;
+  } else if((src & 0xff00) == NHC_UDP_PORT_8) {
+    *nhc |= NHC_UDP_SRC_8;
+    *out++ = src & 0xff;
+    memcpy(out, &udp->destport, 2);
+    out += 2;
+  } else {
+    memcpy(out, &udp->srcport, 4);
+    out += 4;
+  }
+  memcpy(out, &udp->udpchksum, 2);
+  out += 2;
+
+  *hdr_len = out - hdr;
+  return IPH_LEN + UDPH_LEN;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Restore an address from its mode and inline part, return the position
+ * after it or NULL for a mode that is not used on the link
+ */
+static const uint8_t *
+decompress_addr(const uint8_t *in, uint8_t *addr, uint8_t mode)
+{
+  memset(addr, 0, 16);
+
+  if(mode & IPHC_M) {
+    if(mode & IPHC_AC) {
+      return NULL;
+    }
+    switch(mode & IPHC_AM_MASK) {
+    case IPHC_AM_128:
+      memcpy(addr, in, 16);
+      return in + 16;
+    case IPHC_AM_MCAST_8:
+      addr[0] = 0xff;
+      addr[1] = 0x02;
+      addr[15] = *in;
+      return in + 1;
+    }
+    return NULL;
+  }
+
+  if((mode & IPHC_AM_MASK) == IPHC_AM_128) {
+    if(mode & IPHC_AC) {
+      /* the unspecified address */
+      return in;
+    }
+    memcpy(addr, in, 16);
+    return in + 16;
+  }
+
+  if(mode & IPHC_AC) {
+    if(!context_set) {
+      return NULL;
+    }
+    memcpy(addr, context, 8);
+  } else {
+    memcpy(addr, link_local, 8);
+  }
+  switch(mode & IPHC_AM_MASK) {
+  case IPHC_AM_64:
+    memcpy(&addr[8], in, 8);
+    return in + 8;
+  case IPHC_AM_16:
+    addr[11] = 0xff;
+    addr[12] = 0xfe;
+    memcpy(&addr[14], in, 2);
+    return in + 2;
+  }
+  /* derived from the link-layer address, which SLIP does not have */
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+int
+slip_iphc_decompress(uint8_t *buf, uint16_t *len, uint16_t size)
+{
+  uint8_t hdr[IPH_LEN + UDPH_LEN];
+  struct uip_ip_hdr *ip = (struct uip_ip_hdr *)hdr;
+  struct uip_udp_hdr *udp = (struct uip_udp_hdr *)&hdr[IPH_LEN];
+  const uint8_t *in = buf + 2;
+  uint16_t hc_len, hlen, payload_len, src, dst;
+  uint8_t tc, nhc;
+
+  /* no context identifier extension on the link */
+  if(*len < 2 || !slip_iphc_is_compressed(buf) || (buf[1] & IPHC_CID)) {
+    return 0;
+  }
+  memset(hdr, 0, sizeof(hdr));
+
+  ip->vtc = 0x60;
+  if((buf[0] & IPHC_TF_MASK) == IPHC_TF_TC) {
+    tc = (*in >> 6) | (*in << 2);
+    in++;
+    ip->vtc |= tc >> 4;
+    ip->tcflow = tc << 4;
+  }
+
+  ip->proto = (buf[0] & IPHC_NH) ? UIP_PROTO_UDP : *in++;
+
+  switch(buf[0] & IPHC_HLIM_MASK) {
+  case IPHC_HLIM_1:
+    ip->ttl = 1;
+    break;
+  case IPHC_HLIM_64:
+    ip->ttl = 64;
+    break;
+  case IPHC_HLIM_255:
+    ip->ttl = 255;
+    break;
+  default:
+    ip->ttl = *in++;
+  }
+
+  in = decompress_addr(in, ip->srcipaddr.u8,
+                       (buf[1] >> IPHC_SRC_SHIFT) & (IPHC_AC | IPHC_AM_MASK));
+  if(in == NULL) {
+    return 0;
+  }
+  in = decompress_addr(in, ip->destipaddr.u8, buf[1] & 0x0f);
+  if(in == NULL) {
+    return 0;
+  }
+
+  hlen = IPH_LEN;
+  if(buf[0] & IPHC_NH) {
+    nhc = *in++;
+    if((nhc & NHC_UDP_MASK) != NHC_UDP) {
+      return 0;
+    }
+    switch(nhc & NHC_UDP_PORTS_MASK) {
+    case NHC_UDP_PORTS_4:
+      src = NHC_UDP_PORT_4 | (*in >> 4);
+      dst = NHC_UDP_PORT_4 | (*in & 0x0f);
+      in++;
+      break;
+    case NHC_UDP_DST_8:
+      src = (in[0] << 8) | in[1];
+      dst = NHC_UDP_PORT_8 | in[2];
+      in += 3;
+      break;
+    case NHC_UDP_SRC_8:
+      src = NHC_UDP_PORT_8 | in[0];
+      dst = (in[1] << 8) | in[2];
+      in += 3;
+      break;
+    default:
+      src = (in[0] << 8) | in[1];
+      dst = (in[2] << 8) | in[3];
+      in += 4;
+    }
+    udp->srcport = uip_htons(src);
+    udp->destport = uip_htons(dst);
+    memcpy(&udp->udpchksum, in, 2);
+    in += 2;
+    hlen += UDPH_LEN;
+  }
+
+  hc_len = in - buf;
+  if(hc_len > *len) {
+    return 0;
+  }
+  payload_len = *len - hc_len;
+  if(hlen + payload_len > size) {
+    return 0;
+  }
+
+  ip->len[0] = (hlen - IPH_LEN + payload_len) >> 8;
+  ip->len[1] = (hlen - IPH_LEN + payload_len) & 0xff;
+  if(buf[0] & IPHC_NH) {
+    udp->udplen = uip_htons(UDPH_LEN + payload_len);
+  }
+
+  memmove(buf + hlen, buf + hc_len, payload_len);
+  memcpy(buf, hdr, hlen);
+  *len = hlen + payload_len;
+  return 1;
+}
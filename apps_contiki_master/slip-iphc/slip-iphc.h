@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2026, LINGI2146 Group 2.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      IPv6/UDP header compression on the SLIP link to the host
+ *
+ * The headers are compressed with the IPHC and UDP NHC encodings of
+ * RFC 6282. There is no link-layer header to derive addresses from, so
+ * interface identifiers are always carried inline (64 bits, or 16 bits
+ * for 0000:00ff:fe00:XXXX). Context 0 is the prefix the host configured
+ * with !P.
+ *
+ * Only the traffic class forms of IPHC are used (TF = 10 or 11). The
+ * first byte of a compressed packet is then 0x70-0x7f, and an IPv6 packet
+ * starts with 0x60-0x6f, so both kinds can be told apart on the link at
+ * any time. Packets with a flow label are sent uncompressed.
+ */
+
+#ifndef SLIP_IPHC_H_
+#define SLIP_IPHC_H_
+
+#include "net/uip.h"
+
+/* longest compressed IPv6 and UDP header */
+#define SLIP_IPHC_MAX_HDR  44
+
+/**
+ * \brief Sets the prefix that is compressed as context 0
+ * \param prefix The /64 prefix
+ */
+void slip_iphc_set_context(const uip_ipaddr_t *prefix);
+
+/**
+ * \brief Tells whether a packet received from the link is compressed
+ * \param packet The packet
+ * \return Nonzero for a compressed packet
+ */
+int slip_iphc_is_compressed(const uint8_t *packet);
+
+/**
+ * \brief Compresses the headers of an IPv6 packet
+ * \param packet The IPv6 packet
+ * \param len Its length
+ * \param hdr Buffer of SLIP_IPHC_MAX_HDR bytes for the compressed headers
+ * \param hdr_len Length of the compressed headers
+ * \return The number of bytes of the packet replaced by hdr, 0 if the
+ *         packet must be sent as it is
+ */
+uint16_t slip_iphc_compress(const uint8_t *packet, uint16_t len,
+                            uint8_t *hdr, uint8_t *hdr_len);
+
+/**
+ * \brief Restores the IPv6 headers of a compressed packet in place
+ * \param buf The compressed packet
+ * \param len Its length, updated to the length of the IPv6 packet
+ * \param size Size of buf
+ * \return Nonzero on success, 0 for an invalid or too large packet
+ */
+int slip_iphc_decompress(uint8_t *buf, uint16_t *len, uint16_t size);
+
+#endif /* SLIP_IPHC_H_ */
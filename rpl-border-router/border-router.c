@@ -41,6 +41,7 @@
 #include "net/uip.h"
 #include "net/uip-ds6.h"
 #include "net/rpl/rpl.h"
+#include "net/rpl/rpl-private.h"
 
 #include "net/netstack.h"
 #include "dev/button-sensor.h"
@@ -49,6 +50,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <ctype.h>
 
 #define DEBUG DEBUG_NONE
@@ -59,6 +61,35 @@ uint16_t dag_id[] = {0x1111, 0x1100, 0, 0, 0, 0, 0, 0x0011};
 static uip_ipaddr_t prefix;
 static uint8_t prefix_set;
 
+/*
+ * Configuration asked from the host through the SLIP bridge. The prefix is
+ * required; the other keys are only asked during the first rounds since
+ * older hosts do not know them:
+ *   C  radio channel, if the platform gives BORDER_ROUTER_CONF_SET_CHANNEL
+ *   D  RPL instance, DIO interval min and DIO interval doublings
+ * Each round of requests has its own sequence number, and only answers to
+ * the current round are used, until the prefix has been received.
+ * Retries back off exponentially from CONFIG_RETRY_MIN to CONFIG_RETRY_MAX.
+ */
+void slip_config_request(uint8_t key, uint8_t seq);
+#ifdef BORDER_ROUTER_CONF_SET_CHANNEL
+/* the channel setter of the radio driver, e.g. cc2420_set_channel() */
+int BORDER_ROUTER_CONF_SET_CHANNEL(int channel);
+#endif
+#define CONFIG_RETRY_MIN      CLOCK_SECOND
+#define CONFIG_RETRY_MAX      (16 * CLOCK_SECOND)
+#define CONFIG_OPTIONAL_TRIES 3
+static const uint8_t config_optional[] = {
+#ifdef BORDER_ROUTER_CONF_SET_CHANNEL
+  'C',
+#endif
+  'D'
+};
+static uint8_t config_answered;   /* bit i: config_optional[i] */
+static uint8_t config_seq;        /* of the last round of requests */
+static uint8_t dag_instance = RPL_DEFAULT_INSTANCE;
+static uint8_t dio_intmin, dio_intdoubl;  /* 0: RPL defaults */
+
 PROCESS(border_router_process, "Border router process");
 
 #if WEBSERVER==0
@@ -80,14 +111,18 @@ AUTOSTART_PROCESSES(&border_router_process,&webserver_nogui_process);
 #define WEBSERVER_CONF_LOADTIME 0
 #define WEBSERVER_CONF_FILESTATS 0
 #define WEBSERVER_CONF_NEIGHBOR_STATUS 0
-/* Adding links requires a larger RAM buffer. To avoid static allocation
- * the stack can be used for formatting; however tcp retransmissions
- * and multiple connections can result in garbled segments.
- * TODO:use PSOCk_GENERATOR_SEND and tcp state storage to fix this.
+/* Each connection formats the page in its own output buffer, which is
+ * regenerated on tcp retransmissions, so links only need a larger
+ * WEBSERVER_CONF_OUTBUF_SIZE.
  */
 #define WEBSERVER_CONF_ROUTE_LINKS 0
-#if WEBSERVER_CONF_ROUTE_LINKS
-#define BUF_USES_STACK 1
+/* GET /coap/<mote>/<path> is forwarded as a CoAP GET into the mesh. */
+#ifndef WEBSERVER_CONF_COAP_GATEWAY
+#define WEBSERVER_CONF_COAP_GATEWAY 1
+#endif
+#if WEBSERVER_CONF_COAP_GATEWAY
+#include "er-coap-engine.h"
+extern resource_t res_routes, res_route_feed;
 #endif
 
 PROCESS(webserver_nogui_process, "Web server");
@@ -96,6 +131,11 @@ PROCESS_THREAD(webserver_nogui_process, ev, data)
   PROCESS_BEGIN();
 
   httpd_init();
+#if WEBSERVER_CONF_COAP_GATEWAY
+  rest_init_engine();
+  rest_activate_resource(&res_routes, "routes");
+  rest_activate_resource(&res_route_feed, "routes/feed");
+#endif
 
   while(1) {
     PROCESS_WAIT_EVENT_UNTIL(ev == tcpip_event);
@@ -108,49 +148,55 @@ AUTOSTART_PROCESSES(&border_router_process,&webserver_nogui_process);
 
 static const char *TOP = "<html><head><title>ContikiRPL</title></head><body>\n";
 static const char *BOTTOM = "</body></html>\n";
-#if BUF_USES_STACK
-static char *bufptr, *bufend;
+/* formats into the output buffer of the connection s */
 #define ADD(...) do {                                                   \
-    bufptr += snprintf(bufptr, bufend - bufptr, __VA_ARGS__);      \
+    s->outputlen += snprintf(&s->outputbuf[s->outputlen],               \
+                             sizeof(s->outputbuf) - s->outputlen,       \
+                             __VA_ARGS__);                              \
   } while(0)
-#else
-static char buf[256];
-static int blen;
-#define ADD(...) do {                                                   \
-    blen += snprintf(&buf[blen], sizeof(buf) - blen, __VA_ARGS__);      \
-  } while(0)
-#endif
+/* longest line of the neighbor table */
+#define ROUTES_LINE_MAX 52
 
 /*---------------------------------------------------------------------------*/
-static void
-ipaddr_add(const uip_ipaddr_t *addr)
+/* Write an IPv6 address in its compressed text form, return its length */
+static int
+format_ipaddr(char *buf, const uip_ipaddr_t *addr)
 {
   uint16_t a;
   int i, f;
+  int len = 0;
   for(i = 0, f = 0; i < sizeof(uip_ipaddr_t); i += 2) {
     a = (addr->u8[i] << 8) + addr->u8[i + 1];
     if(a == 0 && f >= 0) {
-      if(f++ == 0) ADD("::");
+      if(f++ == 0) {
+        buf[len++] = ':';
+        buf[len++] = ':';
+      }
     } else {
       if(f > 0) {
         f = -1;
       } else if(i > 0) {
-        ADD(":");
+        buf[len++] = ':';
       }
-      ADD("%x", a);
+      len += sprintf(&buf[len], "%x", a);
     }
   }
+  buf[len] = '\0';
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* the callers flush the output buffer before it can overflow */
+static void
+ipaddr_add(struct httpd_state *s, const uip_ipaddr_t *addr)
+{
+  s->outputlen += format_ipaddr(&s->outputbuf[s->outputlen], addr);
 }
 /*---------------------------------------------------------------------------*/
 static
 PT_THREAD(generate_routes(struct httpd_state *s))
 {
-  static int i;
-  static uip_ds6_route_t *r;
-  static uip_ds6_nbr_t *nbr;
-#if BUF_USES_STACK
-  char buf[256];
-#endif
+  uip_ds6_nbr_t *nbr;
+  uip_ds6_route_t *r;
 #if WEBSERVER_CONF_LOADTIME
   static clock_time_t numticks;
   numticks = clock_time();
@@ -158,23 +204,19 @@ PT_THREAD(generate_routes(struct httpd_state *s))
 
   PSOCK_BEGIN(&s->sout);
 
-  SEND_STRING(&s->sout, TOP);
-#if BUF_USES_STACK
-  bufptr = buf;bufend=bufptr+sizeof(buf);
-#else
-  blen = 0;
-#endif
+  SEND_BODY(s, TOP, strlen(TOP));
+  s->outputlen = 0;
   ADD("Neighbors<pre>");
 
-  for(nbr = nbr_table_head(ds6_neighbors);
-      nbr != NULL;
-      nbr = nbr_table_next(ds6_neighbors, nbr)) {
+  for(s->iter = nbr_table_head(ds6_neighbors);
+      s->iter != NULL;
+      s->iter = nbr_table_next(ds6_neighbors, s->iter)) {
+      nbr = (uip_ds6_nbr_t *)s->iter;
 
 #if WEBSERVER_CONF_NEIGHBOR_STATUS
-#if BUF_USES_STACK
-{char* j=bufptr+25;
-      ipaddr_add(&nbr->ipaddr);
-      while (bufptr < j) ADD(" ");
+{uint8_t j=s->outputlen+25;
+      ipaddr_add(s, &nbr->ipaddr);
+      while (s->outputlen < j) ADD(" ");
       switch (nbr->state) {
       case NBR_INCOMPLETE: ADD(" INCOMPLETE");break;
       case NBR_REACHABLE: ADD(" REACHABLE");break;
@@ -184,81 +226,44 @@ PT_THREAD(generate_routes(struct httpd_state *s))
       }
 }
 #else
-{uint8_t j=blen+25;
-      ipaddr_add(&nbr->ipaddr);
-      while (blen < j) ADD(" ");
-      switch (nbr->state) {
-      case NBR_INCOMPLETE: ADD(" INCOMPLETE");break;
-      case NBR_REACHABLE: ADD(" REACHABLE");break;
-      case NBR_STALE: ADD(" STALE");break;      
-      case NBR_DELAY: ADD(" DELAY");break;
-      case NBR_PROBE: ADD(" NBR_PROBE");break;
-      }
-}
-#endif
-#else
-      ipaddr_add(&nbr->ipaddr);
+      ipaddr_add(s, &nbr->ipaddr);
 #endif
 
       ADD("\n");
-#if BUF_USES_STACK
-      if(bufptr > bufend - 45) {
-        SEND_STRING(&s->sout, buf);
-        bufptr = buf; bufend = bufptr + sizeof(buf);
-      }
-#else
-      if(blen > sizeof(buf) - 45) {
-        SEND_STRING(&s->sout, buf);
-        blen = 0;
+      if(s->outputlen > sizeof(s->outputbuf) - ROUTES_LINE_MAX) {
+        SEND_OUTPUT(s);
+        s->outputlen = 0;
       }
-#endif
   }
   ADD("</pre>Routes<pre>");
-  SEND_STRING(&s->sout, buf);
-#if BUF_USES_STACK
-  bufptr = buf; bufend = bufptr + sizeof(buf);
-#else
-  blen = 0;
-#endif
+  SEND_OUTPUT(s);
+  s->outputlen = 0;
 
-  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
+  for(s->iter = uip_ds6_route_head(); s->iter != NULL;
+      s->iter = uip_ds6_route_next(s->iter)) {
+    r = (uip_ds6_route_t *)s->iter;
 
-#if BUF_USES_STACK
 #if WEBSERVER_CONF_ROUTE_LINKS
     ADD("<a href=http://[");
-    ipaddr_add(&r->ipaddr);
+    ipaddr_add(s, &r->ipaddr);
     ADD("]/status.shtml>");
-    ipaddr_add(&r->ipaddr);
+    SEND_OUTPUT(s);
+    s->outputlen = 0;
+    r = (uip_ds6_route_t *)s->iter;
+    ipaddr_add(s, &r->ipaddr);
     ADD("</a>");
 #else
-    ipaddr_add(&r->ipaddr);
-#endif
-#else
-#if WEBSERVER_CONF_ROUTE_LINKS
-    ADD("<a href=http://[");
-    ipaddr_add(&r->ipaddr);
-    ADD("]/status.shtml>");
-    SEND_STRING(&s->sout, buf); //TODO: why tunslip6 needs an output here, wpcapslip does not
-    blen = 0;
-    ipaddr_add(&r->ipaddr);
-    ADD("</a>");
-#else
-    ipaddr_add(&r->ipaddr);
-#endif
+    ipaddr_add(s, &r->ipaddr);
 #endif
     ADD("/%u (via ", r->length);
-    ipaddr_add(uip_ds6_route_nexthop(r));
+    ipaddr_add(s, uip_ds6_route_nexthop(r));
     if(1 || (r->state.lifetime < 600)) {
       ADD(") %lus\n", r->state.lifetime);
     } else {
       ADD(")\n");
     }
-    SEND_STRING(&s->sout, buf);
-#if BUF_USES_STACK
-    bufptr = buf; bufend = bufptr + sizeof(buf);
-#else
-    blen = 0;
-#endif
+    SEND_OUTPUT(s);
+    s->outputlen = 0;
   }
   ADD("</pre>");
 
@@ -272,15 +277,748 @@ PT_THREAD(generate_routes(struct httpd_state *s))
   ADD(" <i>(%u.%02u sec)</i>",numticks/CLOCK_SECOND,(100*(numticks%CLOCK_SECOND))/CLOCK_SECOND));
 #endif
 
-  SEND_STRING(&s->sout, buf);
-  SEND_STRING(&s->sout, BOTTOM);
+  SEND_OUTPUT(s);
+  SEND_BODY(s, BOTTOM, strlen(BOTTOM));
+
+  PSOCK_END(&s->sout);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * routes.json: the neighbor table and the routes with their lifetime,
+ *   {"neighbors":[["<ip>",<state>],..],
+ *    "routes":[["<prefix>",<length>,"<next hop>",<lifetime>],..],
+ *    "seq":<last change of routes/feed included>}
+ * Served over HTTP and as the CoAP resource "routes" (Block2).
+ */
+static const char json_begin[] = "{\"neighbors\":[";
+static const char json_middle[] = "],\"routes\":[";
+/* longest neighbor or route entry */
+#define JSON_ENTRY_MAX 104
+/* longest end of the document */
+#define JSON_END_MAX 16
+
+/* sequence number of the last route change, see routes/feed */
+static uint16_t route_seq;
+
+static int
+json_end(char *buf, uint16_t seq)
+{
+  return sprintf(buf, "],\"seq\":%u}", seq);
+}
+
+static int
+json_neighbor(char *buf, const uip_ds6_nbr_t *nbr, int first)
+{
+  int len = 0;
+
+  if(!first) {
+    buf[len++] = ',';
+  }
+  buf[len++] = '[';
+  buf[len++] = '"';
+  len += format_ipaddr(&buf[len], &nbr->ipaddr);
+  len += sprintf(&buf[len], "\",%u]", nbr->state);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+json_route(char *buf, uip_ds6_route_t *r, int first)
+{
+  int len = 0;
+
+  if(!first) {
+    buf[len++] = ',';
+  }
+  buf[len++] = '[';
+  buf[len++] = '"';
+  len += format_ipaddr(&buf[len], &r->ipaddr);
+  len += sprintf(&buf[len], "\",%u,\"", r->length);
+  len += format_ipaddr(&buf[len], uip_ds6_route_nexthop(r));
+  len += sprintf(&buf[len], "\",%lu]", (unsigned long)r->state.lifetime);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static const char http_header_json[] = "HTTP/1.0 200 OK\r\nConnection: close\r\nContent-type: application/json\r\n\r\n";
+static const char http_header_json_chunked[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nContent-type: application/json\r\n\r\n";
+
+#if HTTPD_OUTBUF_SIZE < JSON_ENTRY_MAX
+#error "WEBSERVER_CONF_OUTBUF_SIZE too small for routes.json entries"
+#endif
+/* an entry is formatted here first to know whether it fits the output */
+static char json_entry[JSON_ENTRY_MAX];
+
+static
+PT_THREAD(generate_routes_json(struct httpd_state *s))
+{
+  int len;
+
+  PSOCK_BEGIN(&s->sout);
+
+  SEND_STRING(&s->sout, s->keepalive ? http_header_json_chunked
+              : http_header_json);
+
+  /* the routes may change while they are sent, give the seq of the start */
+  s->seq = route_seq;
+
+  /* one segment for as many entries as fit the output buffer */
+  strcpy(s->outputbuf, json_begin);
+  s->outputlen = sizeof(json_begin) - 1;
+  for(s->iter = nbr_table_head(ds6_neighbors);
+      s->iter != NULL;
+      s->iter = nbr_table_next(ds6_neighbors, s->iter)) {
+    len = json_neighbor(json_entry, s->iter,
+                        s->iter == nbr_table_head(ds6_neighbors));
+    if(s->outputlen + len > sizeof(s->outputbuf)) {
+      SEND_OUTPUT(s);
+      /* json_entry is shared by the connections, format it again */
+      s->outputlen = json_neighbor(s->outputbuf, s->iter,
+                                   s->iter == nbr_table_head(ds6_neighbors));
+    } else {
+      memcpy(&s->outputbuf[s->outputlen], json_entry, len);
+      s->outputlen += len;
+    }
+  }
+  if(s->outputlen > sizeof(s->outputbuf) - sizeof(json_middle)) {
+    SEND_OUTPUT(s);
+    s->outputlen = 0;
+  }
+  strcpy(&s->outputbuf[s->outputlen], json_middle);
+  s->outputlen += sizeof(json_middle) - 1;
+
+  for(s->iter = uip_ds6_route_head(); s->iter != NULL;
+      s->iter = uip_ds6_route_next(s->iter)) {
+    len = json_route(json_entry, s->iter, s->iter == uip_ds6_route_head());
+    if(s->outputlen + len > sizeof(s->outputbuf)) {
+      SEND_OUTPUT(s);
+      s->outputlen = json_route(s->outputbuf, s->iter,
+                                s->iter == uip_ds6_route_head());
+    } else {
+      memcpy(&s->outputbuf[s->outputlen], json_entry, len);
+      s->outputlen += len;
+    }
+  }
+  if(s->outputlen > sizeof(s->outputbuf) - JSON_END_MAX) {
+    SEND_OUTPUT(s);
+    s->outputlen = 0;
+  }
+  s->outputlen += json_end(&s->outputbuf[s->outputlen], s->seq);
+  SEND_OUTPUT(s);
+
+  PSOCK_END(&s->sout);
+}
+/*---------------------------------------------------------------------------*/
+#if WEBSERVER_CONF_COAP_GATEWAY
+/*
+ * Copy the part of a piece of the document at pos that falls into the
+ * requested block, return the position after the piece. The pieces are
+ * hashed into etag (djb2, start with 5381), so that every block carries
+ * an ETag of the whole document: the document is formatted again for
+ * each block, and a client seeing another ETag knows it changed.
+ */
+static int32_t
+block_add(const char *piece, int len, int32_t pos,
+          uint8_t *buffer, uint16_t preferred_size, int32_t offset,
+          uint32_t *etag)
+{
+  int32_t start, end;
+  int i;
+
+  for(i = 0; i < len; i++) {
+    *etag = (*etag << 5) + *etag + (uint8_t)piece[i];
+  }
+
+  start = MAX(pos, offset);
+  end = MIN(pos + len, offset + preferred_size);
+  if(start < end) {
+    memcpy(buffer + start - offset, piece + start - pos, end - start);
+  }
+  return pos + len;
+}
+/*---------------------------------------------------------------------------*/
+static void
+routes_get_handler(void *request, void *response, uint8_t *buffer,
+                   uint16_t preferred_size, int32_t *offset)
+{
+  char entry[JSON_ENTRY_MAX];
+  uip_ds6_nbr_t *nbr;
+  uip_ds6_route_t *r;
+  int32_t pos = 0; /* position in the whole document */
+  uint32_t etag = 5381;
+
+  /* the document is formatted again for each block, only the requested
+   * block is copied; lifetimes change between blocks, see the ETag */
+  pos = block_add(json_begin, sizeof(json_begin) - 1, pos,
+                  buffer, preferred_size, *offset, &etag);
+  for(nbr = nbr_table_head(ds6_neighbors); nbr != NULL;
+      nbr = nbr_table_next(ds6_neighbors, nbr)) {
+    pos = block_add(entry,
+                    json_neighbor(entry, nbr,
+                                  nbr == nbr_table_head(ds6_neighbors)),
+                    pos, buffer, preferred_size, *offset, &etag);
+  }
+  pos = block_add(json_middle, sizeof(json_middle) - 1, pos,
+                  buffer, preferred_size, *offset, &etag);
+  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
+    pos = block_add(entry, json_route(entry, r, r == uip_ds6_route_head()),
+                    pos, buffer, preferred_size, *offset, &etag);
+  }
+  pos = block_add(entry, json_end(entry, route_seq), pos,
+                  buffer, preferred_size, *offset, &etag);
+
+  if(pos <= *offset) {
+    REST.set_response_status(response, REST.status.BAD_OPTION);
+    REST.set_response_payload(response, "BlockOutOfScope", 15);
+    return;
+  }
+
+  REST.set_header_content_type(response, REST.type.APPLICATION_JSON);
+  REST.set_header_etag(response, (uint8_t *)&etag, sizeof(etag));
+  REST.set_response_payload(response, buffer,
+                            MIN(pos - *offset, preferred_size));
+  if(pos <= *offset + preferred_size) {
+    *offset = -1;
+  } else {
+    *offset += preferred_size;
+  }
+}
+RESOURCE(res_routes,
+         "title=\"Neighbors and routes\";ct=50",
+         routes_get_handler,
+         NULL,
+         NULL,
+         NULL);
+/*---------------------------------------------------------------------------*/
+/*
+ * routes/feed: the route changes as deltas with a sequence number. Every
+ * WEBSERVER_CONF_ROUTE_FEED_PERIOD seconds the routing table is compared
+ * with what was last published. Observers are notified with the new
+ * sequence number, {"seq":<seq>}, and fetch the changes since the last
+ * one they applied with GET routes/feed?since=<seq> (Block2):
+ *   {"deltas":[[<seq>,"+",["<prefix>",<length>,"<next hop>",<lifetime>]],
+ *              [<seq>,"-",["<prefix>",<length>]],..],"seq":<seq>}
+ * "+" is a new route, "~" a new next hop or a refreshed lifetime and "-"
+ * a removed route. A delta shows the current state of its route, so
+ * deltas can be applied on top of a snapshot that is newer than their
+ * seq. 4.04 means the deltas were overwritten: resync from "routes" and
+ * continue from its seq. Like "routes", every block carries the ETag of
+ * the whole document; a client that gets another ETag in a later block
+ * restarts from block 0.
+ */
+#ifndef WEBSERVER_CONF_ROUTE_FEED_PERIOD
+#define WEBSERVER_CONF_ROUTE_FEED_PERIOD 5
+#endif
+/* deltas kept for clients catching up */
+#ifndef WEBSERVER_CONF_ROUTE_FEED_DELTAS
+#define WEBSERVER_CONF_ROUTE_FEED_DELTAS 8
+#endif
+/* lifetime that may be lost between two scans without a refresh */
+#define LIFETIME_JITTER 2
+/* longest delta, a route entry and its "[<seq>,"<op>",..]" */
+#define JSON_DELTA_MAX (JSON_ENTRY_MAX + 12)
+
+struct route_delta {
+  uip_ipaddr_t prefix;
+  uint8_t length;
+  char op;
+};
+/* the last delta_count deltas, the newest one (route_seq) before delta_next */
+static struct route_delta deltas[WEBSERVER_CONF_ROUTE_FEED_DELTAS];
+static uint8_t delta_next, delta_count;
+
+/* a route as it was last published */
+struct route_published {
+  uip_ipaddr_t prefix;
+  uip_ipaddr_t nexthop;
+  unsigned long lifetime;
+  uint8_t length;
+  uint8_t used;
+};
+static struct route_published published[UIP_DS6_ROUTE_NB];
+static unsigned long last_scan;
+/*---------------------------------------------------------------------------*/
+static void
+route_feed_push(const uip_ipaddr_t *prefix, uint8_t length, char op)
+{
+  struct route_delta *d = &deltas[delta_next];
+
+  uip_ipaddr_copy(&d->prefix, prefix);
+  d->length = length;
+  d->op = op;
+  delta_next = (delta_next + 1) % WEBSERVER_CONF_ROUTE_FEED_DELTAS;
+  if(delta_count < WEBSERVER_CONF_ROUTE_FEED_DELTAS) {
+    delta_count++;
+  }
+  route_seq++;
+}
+/*---------------------------------------------------------------------------*/
+static uip_ds6_route_t *
+route_find(const uip_ipaddr_t *prefix, uint8_t length)
+{
+  uip_ds6_route_t *r;
+
+  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
+    if(r->length == length && uip_ipaddr_cmp(&r->ipaddr, prefix)) {
+      return r;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Publish the differences between the routing table and the last scan,
+ * return nonzero if there were any
+ */
+static int
+route_feed_scan(void)
+{
+  struct route_published *p, *unused;
+  uip_ds6_route_t *r;
+  unsigned long elapsed, expected;
+  uint16_t seq = route_seq;
+  char op;
+
+  elapsed = clock_seconds() - last_scan;
+  last_scan = clock_seconds();
+
+  /* removals first, so that their entries can be reused */
+  for(p = published; p < &published[UIP_DS6_ROUTE_NB]; p++) {
+    if(p->used && route_find(&p->prefix, p->length) == NULL) {
+      route_feed_push(&p->prefix, p->length, '-');
+      p->used = 0;
+    }
+  }
+
+  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
+    unused = NULL;
+    for(p = published; p < &published[UIP_DS6_ROUTE_NB]; p++) {
+      if(p->used && p->length == r->length
+         && uip_ipaddr_cmp(&p->prefix, &r->ipaddr)) {
+        break;
+      }
+      if(!p->used && unused == NULL) {
+        unused = p;
+      }
+    }
+
+    if(p == &published[UIP_DS6_ROUTE_NB]) {
+      if(unused == NULL) {
+        /* cannot happen, there are as many entries as routes */
+        continue;
+      }
+      p = unused;
+      uip_ipaddr_copy(&p->prefix, &r->ipaddr);
+      p->length = r->length;
+      p->used = 1;
+      op = '+';
+    } else {
+      /* lifetimes only grow when the route is refreshed */
+      expected = p->lifetime > elapsed ? p->lifetime - elapsed : 0;
+      if(!uip_ipaddr_cmp(&p->nexthop, uip_ds6_route_nexthop(r))
+         || (r->state.lifetime != p->lifetime
+             && r->state.lifetime > expected + LIFETIME_JITTER)) {
+        op = '~';
+      } else {
+        op = 0;
+      }
+    }
+    uip_ipaddr_copy(&p->nexthop, uip_ds6_route_nexthop(r));
+    p->lifetime = r->state.lifetime;
+    if(op) {
+      route_feed_push(&r->ipaddr, r->length, op);
+    }
+  }
+
+  return route_seq != seq;
+}
+/*---------------------------------------------------------------------------*/
+static int
+json_delta(char *buf, const struct route_delta *d, uint16_t seq, int first)
+{
+  uip_ds6_route_t *r;
+  int len = 0;
+
+  if(!first) {
+    buf[len++] = ',';
+  }
+  len += sprintf(&buf[len], "[%u,\"%c\",", seq, d->op);
+  r = d->op == '-' ? NULL : route_find(&d->prefix, d->length);
+  if(r != NULL) {
+    len += json_route(&buf[len], r, 1);
+  } else {
+    /* removed, possibly after the delta */
+    buf[len++] = '[';
+    buf[len++] = '"';
+    len += format_ipaddr(&buf[len], &d->prefix);
+    len += sprintf(&buf[len], "\",%u]", d->length);
+  }
+  buf[len++] = ']';
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static void feed_get_handler(void *request, void *response, uint8_t *buffer,
+                             uint16_t preferred_size, int32_t *offset);
+static void feed_periodic_handler(void);
+
+PERIODIC_RESOURCE(res_route_feed,
+                  "title=\"Route changes\";ct=50;obs",
+                  feed_get_handler,
+                  NULL,
+                  NULL,
+                  NULL,
+                  WEBSERVER_CONF_ROUTE_FEED_PERIOD * CLOCK_SECOND,
+                  feed_periodic_handler);
+
+static void
+feed_get_handler(void *request, void *response, uint8_t *buffer,
+                 uint16_t preferred_size, int32_t *offset)
+{
+  char entry[JSON_DELTA_MAX];
+  const char *value;
+  uint16_t since = 0;
+  uint16_t count, i;
+  int32_t pos = 0;
+  uint32_t etag = 5381;
+  int len;
+
+  REST.set_header_content_type(response, REST.type.APPLICATION_JSON);
+
+  /* notifications have no request (and no offset) */
+  if(request == NULL
+     || !(len = REST.get_query_variable(request, "since", &value))) {
+    REST.set_response_payload(response, buffer,
+                              snprintf((char *)buffer, preferred_size,
+                                       "{\"seq\":%u}", route_seq));
+    return;
+  }
+  /* the value is not 0-terminated in the options */
+  for(i = 0; i < len && isdigit((unsigned char)value[i]); i++) {
+    since = since * 10 + value[i] - '0';
+  }
+
+  count = route_seq - since;
+  if(count > delta_count) {
+    REST.set_response_status(response, REST.status.NOT_FOUND);
+    REST.set_response_payload(response, "SeqExpired", 10);
+    return;
+  }
+
+  /* deltas show the current state of their route and new deltas move
+   * the end of the document, so blocks carry the ETag of the document */
+  pos = block_add("{\"deltas\":[", 11, pos,
+                  buffer, preferred_size, *offset, &etag);
+  for(i = count; i > 0; i--) {
+    pos = block_add(entry,
+                    json_delta(entry,
+                               &deltas[(delta_next
+                                        + WEBSERVER_CONF_ROUTE_FEED_DELTAS - i)
+                                       % WEBSERVER_CONF_ROUTE_FEED_DELTAS],
+                               route_seq - i + 1, i == count),
+                    pos, buffer, preferred_size, *offset, &etag);
+  }
+  pos = block_add(entry, json_end(entry, route_seq), pos,
+                  buffer, preferred_size, *offset, &etag);
+
+  if(pos <= *offset) {
+    REST.set_response_status(response, REST.status.BAD_OPTION);
+    REST.set_response_payload(response, "BlockOutOfScope", 15);
+    return;
+  }
+
+  REST.set_header_etag(response, (uint8_t *)&etag, sizeof(etag));
+  REST.set_response_payload(response, buffer,
+                            MIN(pos - *offset, preferred_size));
+  if(pos <= *offset + preferred_size) {
+    *offset = -1;
+  } else {
+    *offset += preferred_size;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+feed_periodic_handler(void)
+{
+  if(route_feed_scan()) {
+    REST.notify_subscribers(&res_route_feed);
+  }
+}
+#endif /* WEBSERVER_CONF_COAP_GATEWAY */
+/*---------------------------------------------------------------------------*/
+#if WEBSERVER_CONF_COAP_GATEWAY
+/*
+ * HTTP to CoAP gateway: GET /coap/aaaa::212:7401:1:101/temperature/push
+ * is sent as a CoAP GET to that mote. The status line waits for the first
+ * response; Block2 responses are streamed, the next block is only requested
+ * once the previous one went out. Small responses are cached for a few
+ * seconds (at most their Max-Age) for dashboards polling the same page.
+ */
+/* at least 1 */
+#ifndef WEBSERVER_CONF_COAP_CACHE_ENTRIES
+#define WEBSERVER_CONF_COAP_CACHE_ENTRIES 2
+#endif
+#ifndef WEBSERVER_CONF_COAP_CACHE_TTL
+#define WEBSERVER_CONF_COAP_CACHE_TTL 5
+#endif
+/* CoAP retransmissions take longer than the idle timeout of the server */
+#define COAP_GATEWAY_WAIT (CLOCK_SECOND * 100)
+
+struct coap_gateway {
+  struct httpd_state *s;          /* NULL if unused */
+  struct uip_conn *conn;
+  coap_async_request_t *request;  /* NULL once the last block arrived */
+  uint8_t ready;                  /* a block is waiting to be sent */
+  uint8_t more;
+  uint8_t streamed;               /* more than one block */
+  uint8_t code;
+  unsigned int content_format;
+  uint16_t len;
+  uint8_t block[REST_MAX_CHUNK_SIZE];
+  char uri[HTTPD_PATHLEN];        /* path and query, kept during the request */
+  char header[112];
+};
+static struct coap_gateway gateways[COAP_MAX_ASYNC_REQUESTS];
+
+struct coap_gateway_cache {
+  char name[HTTPD_PATHLEN];       /* empty if unused */
+  struct stimer expires;
+  unsigned int content_format;
+  uint16_t len;
+  uint8_t payload[REST_MAX_CHUNK_SIZE];
+};
+static struct coap_gateway_cache cache[WEBSERVER_CONF_COAP_CACHE_ENTRIES];
+
+static const char http_header_503[] = "HTTP/1.0 503 Service Unavailable\r\nConnection: close\r\n\r\n";
+static const char http_connection_close[] = "Connection: close";
+static const char http_chunked[] = "Transfer-Encoding: chunked";
+/*---------------------------------------------------------------------------*/
+static const char *
+http_status(uint8_t code)
+{
+  switch(code) {
+  case NOT_FOUND_4_04:
+    return "404 Not found";
+  case METHOD_NOT_ALLOWED_4_05:
+    return "405 Method not allowed";
+  case SERVICE_UNAVAILABLE_5_03:
+    return "503 Service Unavailable";
+  case GATEWAY_TIMEOUT_5_04:
+    return "504 Gateway Timeout";
+  }
+  if(code < BAD_REQUEST_4_00) {
+    return "200 OK";
+  } else if(code < INTERNAL_SERVER_ERROR_5_00) {
+    return "400 Bad Request";
+  }
+  return "502 Bad Gateway";
+}
+/*---------------------------------------------------------------------------*/
+static const char *
+http_content_type(unsigned int format)
+{
+  switch(format) {
+  case TEXT_PLAIN:
+    return "text/plain";
+  case APPLICATION_LINK_FORMAT:
+    return "application/link-format";
+  case APPLICATION_XML:
+    return "application/xml";
+  case APPLICATION_JSON:
+    return "application/json";
+  }
+  return "application/octet-stream";
+}
+/*---------------------------------------------------------------------------*/
+static int
+gateway_callback(coap_async_request_t *request, coap_packet_t *response,
+                 coap_async_flag_t flag)
+{
+  struct coap_gateway *g = (struct coap_gateway *)request->data;
+  struct coap_gateway_cache *c = &cache[0];
+  uint32_t max_age = COAP_DEFAULT_MAX_AGE;
+  int i;
+
+  if(response != NULL) {
+    g->code = response->code;
+    g->content_format = IS_OPTION(response, COAP_OPTION_CONTENT_FORMAT)
+      ? response->content_format : APPLICATION_OCTET_STREAM;
+    g->len = MIN(response->payload_len, REST_MAX_CHUNK_SIZE);
+    memcpy(g->block, response->payload, g->len);
+  } else {
+    g->code = flag == COAP_ASYNC_TIMEOUT ? GATEWAY_TIMEOUT_5_04
+      : BAD_GATEWAY_5_02;
+    g->len = 0;
+  }
+  g->more = flag == COAP_ASYNC_BLOCK;
+  g->streamed |= g->more;
+
+  if(flag == COAP_ASYNC_DONE && !g->streamed && g->code == CONTENT_2_05) {
+    coap_get_header_max_age(response, &max_age);
+    /* take a free entry, else replace the one that expires first */
+    for(i = 0; i < WEBSERVER_CONF_COAP_CACHE_ENTRIES; i++) {
+      if(cache[i].name[0] == '\0' || stimer_expired(&cache[i].expires)) {
+        c = &cache[i];
+        break;
+      }
+      if(stimer_remaining(&cache[i].expires) < stimer_remaining(&c->expires)) {
+        c = &cache[i];
+      }
+    }
+    if(max_age > 0) {
+      strncpy(c->name, g->s->filename, sizeof(c->name));
+      stimer_set(&c->expires, MIN(max_age, WEBSERVER_CONF_COAP_CACHE_TTL));
+      c->content_format = g->content_format;
+      c->len = g->len;
+      memcpy(c->payload, g->block, g->len);
+    }
+  }
+
+  /* the client frees its context after the last block */
+  if(!g->more) {
+    g->request = NULL;
+  }
+  g->ready = 1;
+  tcpip_poll_tcp(g->conn);
+  /* paused until the block is sent */
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static struct coap_gateway *
+gateway_start(struct httpd_state *s, const char *name)
+{
+  struct coap_gateway *g = NULL;
+  struct coap_gateway_cache *c;
+  uip_ipaddr_t addr;
+  const char *query = NULL;
+  char *path;
+  char *q;
+  int i;
+
+  for(i = 0; i < COAP_MAX_ASYNC_REQUESTS && g == NULL; i++) {
+    if(gateways[i].s == NULL) {
+      g = &gateways[i];
+    }
+  }
+  if(g == NULL) {
+    return NULL;
+  }
+  g->s = s;
+  g->conn = uip_conn;
+  g->request = NULL;
+  g->ready = 1;
+  g->more = 0;
+  g->streamed = 0;
+  g->len = 0;
+
+  for(i = 0; i < WEBSERVER_CONF_COAP_CACHE_ENTRIES; i++) {
+    c = &cache[i];
+    if(c->name[0] && !stimer_expired(&c->expires)
+       && strcmp(c->name, s->filename) == 0) {
+      g->code = CONTENT_2_05;
+      g->content_format = c->content_format;
+      g->len = c->len;
+      memcpy(g->block, c->payload, c->len);
+      return g;
+    }
+  }
+
+  /* <mote>/<path>[?<query>] */
+  strncpy(g->uri, name, sizeof(g->uri));
+  if((path = strchr(g->uri, '/')) == NULL) {
+    g->code = BAD_REQUEST_4_00;
+    return g;
+  }
+  *path++ = '\0';
+  if((q = strchr(path, '?')) != NULL) {
+    *q = '\0';
+    query = q + 1;
+  }
+  if(!uiplib_ipaddrconv(g->uri, &addr)) {
+    g->code = BAD_REQUEST_4_00;
+    return g;
+  }
+
+  g->ready = 0;
+  g->request = coap_async_request(&addr, UIP_HTONS(COAP_DEFAULT_PORT),
+                                  COAP_GET, path, query, NULL, 0,
+                                  gateway_callback, g);
+  if(g->request == NULL) {
+    g->code = SERVICE_UNAVAILABLE_5_03;
+    g->ready = 1;
+  }
+  return g;
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(coap_gateway(struct httpd_state *s))
+{
+  struct coap_gateway *g = (struct coap_gateway *)s->script_data;
+
+  PSOCK_BEGIN(&s->sout);
+
+  if(g == NULL) {
+    /* no body to frame, close instead */
+    s->keepalive = 0;
+    SEND_STRING(&s->sout, http_header_503);
+    PSOCK_EXIT(&s->sout);
+  }
+
+  timer_set(&s->timer, COAP_GATEWAY_WAIT);
+  PSOCK_WAIT_UNTIL(&s->sout, g->ready);
+
+  snprintf(g->header, sizeof(g->header),
+           "HTTP/1.%c %s\r\n%s\r\nContent-type: %s\r\n\r\n",
+           s->keepalive ? '1' : '0', http_status(g->code),
+           s->keepalive ? http_chunked : http_connection_close,
+           http_content_type(g->content_format));
+  SEND_STRING(&s->sout, g->header);
+
+  while(1) {
+    SEND_BODY(s, (char *)g->block, g->len);
+    if(!g->more) {
+      break;
+    }
+    g->ready = 0;
+    coap_async_continue(g->request);
+    PSOCK_WAIT_UNTIL(&s->sout, g->ready);
+  }
 
   PSOCK_END(&s->sout);
 }
 /*---------------------------------------------------------------------------*/
+void
+httpd_simple_script_done(struct httpd_state *s)
+{
+  struct coap_gateway *g = (struct coap_gateway *)s->script_data;
+
+  if(g->request != NULL) {
+    coap_async_cancel(g->request);
+    g->request = NULL;
+  }
+  g->s = NULL;
+  /* coap_gateway() lengthened it for the CoAP exchange */
+  timer_set(&s->timer, HTTPD_IDLE_TIMEOUT);
+}
+#else /* WEBSERVER_CONF_COAP_GATEWAY */
+void
+httpd_simple_script_done(struct httpd_state *s)
+{
+}
+#endif /* WEBSERVER_CONF_COAP_GATEWAY */
+/*---------------------------------------------------------------------------*/
 httpd_simple_script_t
-httpd_simple_get_script(const char *name)
+httpd_simple_get_script(struct httpd_state *s, const char *name)
 {
+#if WEBSERVER_CONF_COAP_GATEWAY
+  if(strncmp(name, "coap/", 5) == 0) {
+    s->script_headers = 1;
+    s->script_data = gateway_start(s, name + 5);
+    return coap_gateway;
+  }
+#endif
+
+  if(strcmp(name, "routes.json") == 0) {
+    s->script_headers = 1;
+    return generate_routes_json;
+  }
 
   return generate_routes;
 }
@@ -306,15 +1044,93 @@ print_local_addresses(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * RPL turns the DIO interval exponent into (1UL << exp) * CLOCK_SECOND / 1000
+ * ticks of a clock_time_t (16 bits on the Z1: at most 18)
+ */
+static int
+dio_interval_fits(int exp)
+{
+  return exp < 32 && (1UL << exp) <= ULONG_MAX / CLOCK_SECOND
+    && (1UL << exp) * CLOCK_SECOND / 1000 <= (clock_time_t)~0;
+}
+/*---------------------------------------------------------------------------*/
+/* Called by the SLIP bridge for the answers other than the prefix */
 void
-request_prefix(void)
+set_config(uint8_t key, uint8_t seq, const uint8_t *value, uint16_t len)
 {
-  /* mess up uip_buf with a dirty request... */
-  uip_buf[0] = '?';
-  uip_buf[1] = 'P';
-  uip_len = 2;
-  slip_send();
-  uip_len = 0;
+  int i;
+
+  /* the values are used when the prefix arrives, later answers are ignored */
+  if(prefix_set || seq != config_seq) {
+    return;
+  }
+
+  switch(key) {
+#ifdef BORDER_ROUTER_CONF_SET_CHANNEL
+  case 'C':
+    if(len < 1 || value[0] < 11 || value[0] > 26) {
+      return;
+    }
+    BORDER_ROUTER_CONF_SET_CHANNEL(value[0]);
+    break;
+#endif
+  case 'D':
+    /* a DODAG root needs a global instance (below 128) */
+    if(len < 3 || value[0] >= 128
+       || !dio_interval_fits(value[1] + value[2])) {
+      return;
+    }
+    dag_instance = value[0];
+    dio_intmin = value[1];
+    dio_intdoubl = value[2];
+    break;
+  default:
+    return;
+  }
+
+  for(i = 0; i < sizeof(config_optional); i++) {
+    if(config_optional[i] == key) {
+      config_answered |= 1 << i;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Become the root of a DAG, with the parameters of the host if it gave any */
+static rpl_dag_t *
+create_dag(uip_ipaddr_t *id)
+{
+  rpl_dag_t *dag;
+
+  dag = rpl_set_root(dag_instance, id);
+  if(dag != NULL) {
+    rpl_set_prefix(dag, &prefix, 64);
+    if(dio_intmin != 0) {
+      dag->instance->dio_intmin = dio_intmin;
+      dag->instance->dio_intdoubl = dio_intdoubl;
+      rpl_reset_dio_timer(dag->instance);
+    }
+    PRINTF("created a new RPL dag\n");
+  }
+  return dag;
+}
+/*---------------------------------------------------------------------------*/
+/* Ask the keys that are still missing */
+static void
+request_config(uint8_t tries)
+{
+  int i;
+
+  config_seq++;
+  /* the optional keys first, so that they are answered before the prefix */
+  if(tries < CONFIG_OPTIONAL_TRIES) {
+    for(i = 0; i < sizeof(config_optional); i++) {
+      if(!(config_answered & (1 << i))) {
+        slip_config_request(config_optional[i], config_seq);
+      }
+    }
+  }
+  slip_config_request('P', config_seq);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -326,12 +1142,14 @@ set_prefix_64(uip_ipaddr_t *prefix_64)
   prefix_set = 1;
   uip_ds6_set_addr_iid(&ipaddr, &uip_lladdr);
   uip_ds6_addr_add(&ipaddr, 0, ADDR_AUTOCONF);
+  process_poll(&border_router_process);
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(border_router_process, ev, data)
 {
   static struct etimer et;
-  rpl_dag_t *dag;
+  static clock_time_t interval;
+  static uint8_t tries;
 
   PROCESS_BEGIN();
 
@@ -356,18 +1174,20 @@ PROCESS_THREAD(border_router_process, ev, data)
   NETSTACK_MAC.off(1);
 #endif
  
-  /* Request prefix until it has been received */
-  while(!prefix_set) {
-    etimer_set(&et, CLOCK_SECOND);
-    request_prefix();
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  /* Request the configuration until the prefix has been received, the
+   * answer polls the process so that the radio is turned on right away */
+  interval = CONFIG_RETRY_MIN;
+  for(tries = 0; !prefix_set; tries++) {
+    request_config(tries);
+    etimer_set(&et, interval);
+    PROCESS_WAIT_EVENT_UNTIL(prefix_set || etimer_expired(&et));
+    if(interval < CONFIG_RETRY_MAX) {
+      interval *= 2;
+    }
   }
+  etimer_stop(&et);
 
-  dag = rpl_set_root(RPL_DEFAULT_INSTANCE,(uip_ip6addr_t *)dag_id);
-  if(dag != NULL) {
-    rpl_set_prefix(dag, &prefix, 64);
-    PRINTF("created a new RPL dag\n");
-  }
+  create_dag((uip_ip6addr_t *)dag_id);
 
   /* Now turn the radio on, but disable radio duty cycling.
    * Since we are the DAG root, reception delays would constrain mesh throughbut.
@@ -382,7 +1202,7 @@ PROCESS_THREAD(border_router_process, ev, data)
     PROCESS_YIELD();
     if (ev == sensors_event && data == &button_sensor) {
       PRINTF("Initiating global repair\n");
-      rpl_repair_root(RPL_DEFAULT_INSTANCE);
+      rpl_repair_root(dag_instance);
     }
   }
 
@@ -60,12 +60,10 @@
 #define URLCONV WEBSERVER_CONF_CFS_URLCONV
 #endif /* WEBSERVER_CONF_CFS_URLCONV */
 
-#define STATE_WAITING 0
-#define STATE_OUTPUT  1
-
 MEMB(conns, struct httpd_state, CONNS);
 
 #define ISO_nl      0x0a
+#define ISO_cr      0x0d
 #define ISO_space   0x20
 #define ISO_period  0x2e
 #define ISO_slash   0x2f
@@ -78,11 +76,52 @@ static const char *NOT_FOUND = "<html><body bgcolor=\"white\">"
 "</body>"
 "</html>";
 /*---------------------------------------------------------------------------*/
+/*
+ * Generator for PSOCK_GENERATOR_SEND(): the next part of the body, framed
+ * as a chunk on persistent connections. Only depends on the connection
+ * state, so a retransmission generates the same segment.
+ */
+unsigned short
+httpd_simple_generate(void *state)
+{
+  struct httpd_state *s = (struct httpd_state *)state;
+  char *out = (char *)uip_appdata;
+  unsigned short len = s->bodylen;
+  int n = 0;
+
+  /* chunk size line (at most 4 digits) and CRLF trailer */
+  if(len > uip_mss() - 8) {
+    len = uip_mss() - 8;
+  }
+  s->chunklen = len;
+
+  if(s->keepalive) {
+    n = sprintf(out, "%x\r\n", len);
+  }
+  memcpy(out + n, s->body, len);
+  n += len;
+  if(s->keepalive) {
+    out[n++] = ISO_cr;
+    out[n++] = ISO_nl;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
 static
 PT_THREAD(send_string(struct httpd_state *s, const char *str))
 {
   PSOCK_BEGIN(&s->sout);
 
+  SEND_BODY(s, str, strlen(str));
+
+  PSOCK_END(&s->sout);
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(send_raw(struct httpd_state *s, const char *str))
+{
+  PSOCK_BEGIN(&s->sout);
+
   SEND_STRING(&s->sout, str);
 
   PSOCK_END(&s->sout);
@@ -121,77 +160,141 @@ PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr))
 /*---------------------------------------------------------------------------*/
 const char http_header_200[] = "HTTP/1.0 200 OK\r\nServer: Contiki/2.4 http://www.sics.se/contiki/\r\nConnection: close\r\n";
 const char http_header_404[] = "HTTP/1.0 404 Not found\r\nServer: Contiki/2.4 http://www.sics.se/contiki/\r\nConnection: close\r\n";
+const char http_header_200_chunked[] = "HTTP/1.1 200 OK\r\nServer: Contiki/2.4 http://www.sics.se/contiki/\r\nTransfer-Encoding: chunked\r\n";
+const char http_header_404_chunked[] = "HTTP/1.1 404 Not found\r\nServer: Contiki/2.4 http://www.sics.se/contiki/\r\nTransfer-Encoding: chunked\r\n";
+const char http_last_chunk[] = "0\r\n\r\n";
 static
 PT_THREAD(handle_output(struct httpd_state *s))
 {
   PT_BEGIN(&s->outputpt);
 
-  s->script = NULL;
-  s->script = httpd_simple_get_script(&s->filename[1]);
-  if(s->script == NULL) {
-    strncpy(s->filename, "/notfound.html", sizeof(s->filename));
-    PT_WAIT_THREAD(&s->outputpt,
-                   send_headers(s, http_header_404));
-    PT_WAIT_THREAD(&s->outputpt,
-                   send_string(s, NOT_FOUND));
-    uip_close();
-    webserver_log_file(&uip_conn->ripaddr, "404 - not found");
-    PT_EXIT(&s->outputpt);
-  } else {
-    PT_WAIT_THREAD(&s->outputpt,
-                   send_headers(s, http_header_200));
-    PT_WAIT_THREAD(&s->outputpt, s->script(s));
+  /* answer the queued requests in order */
+  while(1) {
+    PT_WAIT_UNTIL(&s->outputpt, s->count > 0);
+    s->filename = s->requests[s->head].filename;
+    s->keepalive = s->requests[s->head].keepalive;
+
+    s->script = NULL;
+    s->script_headers = 0;
+    s->script = httpd_simple_get_script(s, &s->filename[1]);
+    if(s->script == NULL) {
+      PT_WAIT_THREAD(&s->outputpt,
+                     send_headers(s, s->keepalive ? http_header_404_chunked
+                                  : http_header_404));
+      PT_WAIT_THREAD(&s->outputpt,
+                     send_string(s, NOT_FOUND));
+      webserver_log_file(&uip_conn->ripaddr, "404 - not found");
+    } else {
+      if(!s->script_headers) {
+        PT_WAIT_THREAD(&s->outputpt,
+                       send_headers(s, s->keepalive ? http_header_200_chunked
+                                    : http_header_200));
+      }
+      PT_WAIT_THREAD(&s->outputpt, s->script(s));
+    }
+    if(s->script_data != NULL) {
+      httpd_simple_script_done(s);
+      s->script_data = NULL;
+    }
+    s->script = NULL;
+
+    /* a script may have fallen back to a closed connection */
+    if(!s->keepalive) {
+      break;
+    }
+    PT_WAIT_THREAD(&s->outputpt, send_raw(s, http_last_chunk));
+
+    s->head = (s->head + 1) % HTTPD_QUEUE;
+    s->count--;
   }
-  s->script = NULL;
   PSOCK_CLOSE(&s->sout);
   PT_END(&s->outputpt);
 }
 /*---------------------------------------------------------------------------*/
 const char http_get[] = "GET ";
 const char http_index_html[] = "/index.html";
+const char http_11[] = "HTTP/1.1";
+const char http_connection_close[] = "Connection: close";
 //const char http_referer[] = "Referer:"
 static
 PT_THREAD(handle_input(struct httpd_state *s))
 {
+  struct httpd_request *r = &s->requests[(s->head + s->count) % HTTPD_QUEUE];
+
   PSOCK_BEGIN(&s->sin);
 
-  PSOCK_READTO(&s->sin, ISO_space);
+  while(1) {
+    /* the queue only matters once the next request comes in */
+    PSOCK_WAIT_UNTIL(&s->sin, s->count < HTTPD_QUEUE
+                     || PSOCK_NEWDATA(&s->sin));
+    if(s->count == HTTPD_QUEUE) {
+      /* too deep: answer the queued requests and close, the client retries */
+      s->requests[(s->head + s->count - 1) % HTTPD_QUEUE].keepalive = 0;
+      break;
+    }
 
-  if(strncmp(s->inputbuf, http_get, 4) != 0) {
-    PSOCK_CLOSE_EXIT(&s->sin);
-  }
-  PSOCK_READTO(&s->sin, ISO_space);
+    PSOCK_READTO(&s->sin, ISO_space);
 
-  if(s->inputbuf[0] != ISO_slash) {
-    PSOCK_CLOSE_EXIT(&s->sin);
-  }
+    if(strncmp(s->inputbuf, http_get, 4) != 0) {
+      PSOCK_CLOSE_EXIT(&s->sin);
+    }
+    PSOCK_READTO(&s->sin, ISO_space);
+
+    if(s->inputbuf[0] != ISO_slash) {
+      PSOCK_CLOSE_EXIT(&s->sin);
+    }
 
 #if URLCONV
-  s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] = 0;
-  urlconv_tofilename(s->filename, s->inputbuf, sizeof(s->filename));
-#else /* URLCONV */
-  if(s->inputbuf[1] == ISO_space) {
-    strncpy(s->filename, http_index_html, sizeof(s->filename));
-  } else {
     s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] = 0;
-    strncpy(s->filename, s->inputbuf, sizeof(s->filename));
-  }
+    urlconv_tofilename(r->filename, s->inputbuf, sizeof(r->filename));
+#else /* URLCONV */
+    if(s->inputbuf[1] == ISO_space) {
+      strncpy(r->filename, http_index_html, sizeof(r->filename));
+    } else {
+      s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] = 0;
+      strncpy(r->filename, s->inputbuf, sizeof(r->filename));
+    }
+    r->filename[sizeof(r->filename) - 1] = 0;
 #endif /* URLCONV */
 
-  webserver_log_file(&uip_conn->ripaddr, s->filename);
+    webserver_log_file(&uip_conn->ripaddr, r->filename);
 
-  s->state = STATE_OUTPUT;
-
-  while(1) {
+    /* HTTP/1.1 connections are persistent unless the client says otherwise */
     PSOCK_READTO(&s->sin, ISO_nl);
+    r->keepalive = strncmp(s->inputbuf, http_11, sizeof(http_11) - 1) == 0;
+
+    /* headers up to the empty line; long lines are read in several parts */
+    s->line_start = 1;
+    while(1) {
+      PSOCK_READTO(&s->sin, ISO_nl);
+      if(s->line_start && (s->inputbuf[0] == ISO_nl
+                           || (s->inputbuf[0] == ISO_cr
+                               && s->inputbuf[1] == ISO_nl))) {
+        break;
+      }
+      /* field names and connection options are case-insensitive */
+      if(s->line_start && strncasecmp(s->inputbuf, http_connection_close,
+                                      sizeof(http_connection_close) - 1) == 0) {
+        r->keepalive = 0;
+      }
 #if 0
-    if(strncmp(s->inputbuf, http_referer, 8) == 0) {
-      s->inputbuf[PSOCK_DATALEN(&s->sin) - 2] = 0;
-      webserver_log(s->inputbuf);
-    }
+      if(strncmp(s->inputbuf, http_referer, 8) == 0) {
+        s->inputbuf[PSOCK_DATALEN(&s->sin) - 2] = 0;
+        webserver_log(s->inputbuf);
+      }
 #endif
+      s->line_start = s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] == ISO_nl;
+    }
+
+    s->count++;
+    if(!r->keepalive) {
+      break;
+    }
   }
 
+  /* ignore anything after the last request that will be answered */
+  PSOCK_WAIT_UNTIL(&s->sin, 0);
+
   PSOCK_END(&s->sin);
 }
 /*---------------------------------------------------------------------------*/
@@ -199,11 +302,20 @@ static void
 handle_connection(struct httpd_state *s)
 {
   handle_input(s);
-  if(s->state == STATE_OUTPUT) {
-    handle_output(s);
-  }
+  handle_output(s);
 }
 
+/*---------------------------------------------------------------------------*/
+static void
+free_connection(struct httpd_state *s)
+{
+  if(s->script_data != NULL) {
+    httpd_simple_script_done(s);
+    s->script_data = NULL;
+  }
+  s->script = NULL;
+  memb_free(&conns, s);
+}
 /*---------------------------------------------------------------------------*/
 void
 httpd_appcall(void *state)
@@ -212,8 +324,7 @@ httpd_appcall(void *state)
 
   if(uip_closed() || uip_aborted() || uip_timedout()) {
     if(s != NULL) {
-      s->script = NULL;
-      memb_free(&conns, s);
+      free_connection(s);
     }
   } else if(uip_connected()) {
     s = (struct httpd_state *)memb_alloc(&conns);
@@ -224,19 +335,21 @@ httpd_appcall(void *state)
     }
     tcp_markconn(uip_conn, s);
     PSOCK_INIT(&s->sin, (uint8_t *)s->inputbuf, sizeof(s->inputbuf) - 1);
-    PSOCK_INIT(&s->sout, (uint8_t *)s->inputbuf, sizeof(s->inputbuf) - 1);
+    /* sout never reads, its buffer is only given to satisfy PSOCK_INIT */
+    PSOCK_INIT(&s->sout, (uint8_t *)s->outputbuf, sizeof(s->outputbuf));
     PT_INIT(&s->outputpt);
     s->script = NULL;
-    s->state = STATE_WAITING;
-    timer_set(&s->timer, CLOCK_SECOND * 10);
+    s->script_data = NULL;
+    s->head = s->count = 0;
+    timer_set(&s->timer, HTTPD_IDLE_TIMEOUT);
     handle_connection(s);
   } else if(s != NULL) {
     if(uip_poll()) {
       if(timer_expired(&s->timer)) {
         uip_abort();
-        s->script = NULL;
-        memb_free(&conns, s);
+        free_connection(s);
         webserver_log_file(&uip_conn->ripaddr, "reset (timeout)");
+        return;
       }
     } else {
       timer_restart(&s->timer);
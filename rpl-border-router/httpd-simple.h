@@ -43,32 +43,92 @@
 #include "contiki-net.h"
 
 /* The current internal border router webserver ignores the requested file name */
-/* and needs no per-connection output buffer, so save some RAM */
+/* unless the CoAP gateway is used, so save some RAM */
 #ifndef WEBSERVER_CONF_CFS_PATHLEN
 #define HTTPD_PATHLEN 2
 #else /* WEBSERVER_CONF_CFS_CONNS */
 #define HTTPD_PATHLEN WEBSERVER_CONF_CFS_PATHLEN
 #endif /* WEBSERVER_CONF_CFS_CONNS */
 
+/* Requests read ahead on a persistent connection while a response is sent */
+#ifndef WEBSERVER_CONF_PIPELINE
+#define HTTPD_PIPELINE 1
+#else /* WEBSERVER_CONF_PIPELINE */
+#define HTTPD_PIPELINE WEBSERVER_CONF_PIPELINE
+#endif /* WEBSERVER_CONF_PIPELINE */
+#define HTTPD_QUEUE (HTTPD_PIPELINE + 1)
+
+/* Per-connection buffer in which scripts format the response body */
+#ifndef WEBSERVER_CONF_OUTBUF_SIZE
+#define HTTPD_OUTBUF_SIZE 128
+#else /* WEBSERVER_CONF_OUTBUF_SIZE */
+#define HTTPD_OUTBUF_SIZE WEBSERVER_CONF_OUTBUF_SIZE
+#endif /* WEBSERVER_CONF_OUTBUF_SIZE */
+
+/* A connection without activity for this long is reset */
+#define HTTPD_IDLE_TIMEOUT (CLOCK_SECOND * 10)
+
 struct httpd_state;
 typedef char (* httpd_simple_script_t)(struct httpd_state *s);
 
+struct httpd_request {
+  char filename[HTTPD_PATHLEN];
+  char keepalive;       /* HTTP/1.1 without "Connection: close" */
+};
+
 struct httpd_state {
   struct timer timer;
   struct psock sin, sout;
   struct pt outputpt;
   char inputbuf[HTTPD_PATHLEN + 24];
-/*char outputbuf[UIP_TCP_MSS]; */
-  char filename[HTTPD_PATHLEN];
+  char outputbuf[HTTPD_OUTBUF_SIZE];
+  unsigned short outputlen;
+  const char *body;     /* body data being sent, see SEND_BODY() */
+  unsigned short bodylen;
+  unsigned short chunklen;
+  struct httpd_request requests[HTTPD_QUEUE];
+  uint8_t head, count;  /* requests read but not answered yet */
+  char line_start;      /* the input is at the start of a line */
+  const char *filename; /* of the request being answered */
+  char keepalive;       /* of the request being answered: chunked body */
   httpd_simple_script_t script;
-  char state;
+  void *script_data;    /* owned by the script until httpd_simple_script_done() */
+  void *iter;           /* position of a script in the table it sends */
+  uint16_t seq;         /* version of the data a script sends */
+  char script_headers;  /* the script sends its own status line and headers */
 };
 
 void httpd_init(void);
 void httpd_appcall(void *state);
 
-httpd_simple_script_t httpd_simple_get_script(const char *name);
+/* Implemented by the application: the script for a page name */
+httpd_simple_script_t httpd_simple_get_script(struct httpd_state *s,
+                                              const char *name);
+/* Implemented by the application: the response of s is over or its connection is gone */
+void httpd_simple_script_done(struct httpd_state *s);
+
+unsigned short httpd_simple_generate(void *state);
 
+/* Raw data, for the status line and headers */
 #define SEND_STRING(s, str) PSOCK_SEND(s, (uint8_t *)str, strlen(str))
 
+/*
+ * Response body, chunked on persistent connections. Each segment is
+ * generated from (data, len), which must stay unchanged until sent, so
+ * retransmissions are correct whatever the other connections do.
+ */
+#define SEND_BODY(s, data, len)                                         \
+  do {                                                                  \
+    (s)->body = (data);                                                 \
+    (s)->bodylen = (len);                                               \
+    while((s)->bodylen > 0) {                                           \
+      PSOCK_GENERATOR_SEND(&(s)->sout, httpd_simple_generate, (s));     \
+      (s)->body += (s)->chunklen;                                       \
+      (s)->bodylen -= (s)->chunklen;                                    \
+    }                                                                   \
+  } while(0)
+
+/* The body formatted in outputbuf */
+#define SEND_OUTPUT(s) SEND_BODY(s, (s)->outputbuf, (s)->outputlen)
+
 #endif /* __HTTPD_SIMPLE_H__ */
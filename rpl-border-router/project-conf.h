@@ -51,4 +51,31 @@
 #define WEBSERVER_CONF_CFS_CONNS 2
 #endif
 
+/* Several routes.json entries per flush of a connection */
+#ifndef WEBSERVER_CONF_OUTBUF_SIZE
+#define WEBSERVER_CONF_OUTBUF_SIZE 256
+#endif
+
+/* Room for /coap/<mote>/<path> requests of the CoAP gateway */
+#ifndef WEBSERVER_CONF_CFS_PATHLEN
+#define WEBSERVER_CONF_CFS_PATHLEN 64
+#endif
+
+/* The gateway only needs the async client of the CoAP engine */
+#undef REST_MAX_CHUNK_SIZE
+#define REST_MAX_CHUNK_SIZE      64
+#undef COAP_MAX_OPEN_TRANSACTIONS
+#define COAP_MAX_OPEN_TRANSACTIONS 2
+#undef COAP_ASYNC_CLIENT
+#define COAP_ASYNC_CLIENT        1
+
+/* SLIP frames fill the UART0 transmit ring, drained by the TX interrupt. */
+#undef UART0_CONF_TX_WITH_INTERRUPT
+#define UART0_CONF_TX_WITH_INTERRUPT   1
+
+/* The host may set the channel of the CC2420 of the Z1 (?C). */
+#ifndef BORDER_ROUTER_CONF_SET_CHANNEL
+#define BORDER_ROUTER_CONF_SET_CHANNEL cc2420_set_channel
+#endif
+
 #endif /* __PROJECT_ROUTER_CONF_H__ */
@@ -44,14 +44,134 @@
 #include "dev/uart1.h"
 #include <string.h>
 
+/* Header compression on the link, used once the host asks for it (?H),
+   see tools/slip-iphc.py */
+#ifndef SLIP_BRIDGE_CONF_IPHC
+#define SLIP_BRIDGE_CONF_IPHC 1
+#endif
+#if SLIP_BRIDGE_CONF_IPHC
+#include "slip-iphc.h"
+#endif
+
 #define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
 
 #define DEBUG DEBUG_PRINT
 #include "net/uip-debug.h"
 
+/* Must match the -B option of tunslip6 */
+#ifdef SLIP_BRIDGE_CONF_BAUDRATE
+#define SLIP_BRIDGE_BAUDRATE SLIP_BRIDGE_CONF_BAUDRATE
+#else
+#define SLIP_BRIDGE_BAUDRATE 115200
+#endif
+
+/* Debug output is held until the end of the line, then framed at once */
+#ifdef SLIP_BRIDGE_CONF_DEBUG_LINE
+#define SLIP_BRIDGE_DEBUG_LINE SLIP_BRIDGE_CONF_DEBUG_LINE
+#else
+#define SLIP_BRIDGE_DEBUG_LINE 80
+#endif
+
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
 void set_prefix_64(uip_ipaddr_t *);
+void set_config(uint8_t key, uint8_t seq, const uint8_t *value,
+                uint16_t len);
 
 static uip_ipaddr_t last_sender;
+
+/* the last byte sent was a SLIP_END, which also starts the next frame */
+static uint8_t tx_end;
+#if SLIP_BRIDGE_CONF_IPHC
+/* the host decompresses the packets we send */
+static uint8_t iphc_enabled;
+#endif
+/*---------------------------------------------------------------------------*/
+/*
+ * Frames are written here rather than with slip_send(), so that back to
+ * back frames share one SLIP_END and debug lines cannot end up inside an
+ * IP frame. With UART0_CONF_TX_WITH_INTERRUPT the writes only fill the
+ * transmit ring of the UART, which the TX interrupt drains.
+ */
+static void
+frame_begin(void)
+{
+  if(!tx_end) {
+    slip_arch_writeb(SLIP_END);
+  }
+  tx_end = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+frame_data(const uint8_t *data, uint16_t len)
+{
+  uint16_t i;
+
+  for(i = 0; i < len; i++) {
+    if(data[i] == SLIP_END) {
+      slip_arch_writeb(SLIP_ESC);
+      slip_arch_writeb(SLIP_ESC_END);
+    } else if(data[i] == SLIP_ESC) {
+      slip_arch_writeb(SLIP_ESC);
+      slip_arch_writeb(SLIP_ESC_ESC);
+    } else {
+      slip_arch_writeb(data[i]);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+frame_end(void)
+{
+  slip_arch_writeb(SLIP_END);
+  tx_end = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_packet(void)
+{
+#if SLIP_BRIDGE_CONF_IPHC
+  uint8_t hdr[SLIP_IPHC_MAX_HDR];
+  uint8_t hdr_len;
+  uint16_t replaced;
+
+  if(iphc_enabled
+     && (replaced = slip_iphc_compress(&uip_buf[UIP_LLH_LEN], uip_len,
+                                       hdr, &hdr_len)) > 0) {
+    frame_begin();
+    frame_data(hdr, hdr_len);
+    frame_data(&uip_buf[UIP_LLH_LEN + replaced], uip_len - replaced);
+    frame_end();
+    return;
+  }
+#endif
+  frame_begin();
+  frame_data(&uip_buf[UIP_LLH_LEN], uip_len);
+  frame_end();
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Configuration channel: "?<key><seq>" asks the host for a value, which
+ * comes back as "!<key><seq><value>", so that a late answer to an older
+ * request can be told apart. The prefix is the exception: tunslip6
+ * answers "!P<prefix>" without the sequence number. The request is framed
+ * from its own buffer, so that a packet in uip_buf is left alone.
+ */
+void
+slip_config_request(uint8_t key, uint8_t seq)
+{
+  uint8_t request[3];
+
+  request[0] = '?';
+  request[1] = key;
+  request[2] = seq;
+  frame_begin();
+  frame_data(request, sizeof(request));
+  frame_end();
+}
 /*---------------------------------------------------------------------------*/
 static void
 slip_input_callback(void)
@@ -59,6 +179,9 @@ slip_input_callback(void)
  // PRINTF("SIN: %u\n", uip_len);
   if(uip_buf[0] == '!') {
     PRINTF("Got configuration message of type %c\n", uip_buf[1]);
+    if(uip_len >= 3 && uip_buf[1] != 'P' && uip_buf[1] != 'H') {
+      set_config(uip_buf[1], uip_buf[2], &uip_buf[3], uip_len - 3);
+    }
     uip_len = 0;
     if(uip_buf[1] == 'P') {
       uip_ipaddr_t prefix;
@@ -69,7 +192,16 @@ slip_input_callback(void)
       PRINT6ADDR(&prefix);
       PRINTF("\n");
       set_prefix_64(&prefix);
+#if SLIP_BRIDGE_CONF_IPHC
+      slip_iphc_set_context(&prefix);
+#endif
     }
+#if SLIP_BRIDGE_CONF_IPHC
+    else if(uip_buf[1] == 'H') {
+      /* !H0 stops compressing, !H1 starts again */
+      iphc_enabled = uip_buf[2] == '1';
+    }
+#endif
   } else if (uip_buf[0] == '?') {
     PRINTF("Got request message of type %c\n", uip_buf[1]);
     if(uip_buf[1] == 'M') {
@@ -82,11 +214,31 @@ slip_input_callback(void)
         uip_buf[3 + j * 2] = hexchar[uip_lladdr.addr[j] & 15];
       }
       uip_len = 18;
-      slip_send();
+      send_packet();
       
     }
+#if SLIP_BRIDGE_CONF_IPHC
+    else if(uip_buf[1] == 'H') {
+      /* the host decompresses from now on, answer !H1 */
+      uip_buf[0] = '!';
+      uip_buf[2] = '1';
+      uip_len = 3;
+      send_packet();
+      iphc_enabled = 1;
+    }
+#endif
     uip_len = 0;
   }
+#if SLIP_BRIDGE_CONF_IPHC
+  else if(slip_iphc_is_compressed(&uip_buf[UIP_LLH_LEN])) {
+    if(!slip_iphc_decompress(&uip_buf[UIP_LLH_LEN], &uip_len,
+                             UIP_BUFSIZE - UIP_LLH_LEN)) {
+      PRINTF("slip-bridge: bad compressed packet\n");
+      uip_len = 0;
+      return;
+    }
+  }
+#endif
   /* Save the last sender received over SLIP to avoid bouncing the
      packet back if no route is found */
   uip_ipaddr_copy(&last_sender, &UIP_IP_BUF->srcipaddr);
@@ -95,7 +247,7 @@ slip_input_callback(void)
 static void
 init(void)
 {
-  slip_arch_init(BAUD2UBR(115200));
+  slip_arch_init(BAUD2UBR(SLIP_BRIDGE_BAUDRATE));
   process_start(&slip_process, NULL);
   slip_set_input_callback(slip_input_callback);
 }
@@ -113,7 +265,7 @@ output(void)
     PRINTF("\n");
   } else {
  //   PRINTF("SUT: %u\n", uip_len);
-    slip_send();
+    send_packet();
   }
 }
 
@@ -123,26 +275,22 @@ output(void)
 int
 putchar(int c)
 {
-#define SLIP_END     0300
-  static char debug_frame = 0;
+  static uint8_t debug_line[SLIP_BRIDGE_DEBUG_LINE];
+  static uint8_t debug_len = 0;
 
-  if(!debug_frame) {            /* Start of debug output */
-    slip_arch_writeb(SLIP_END);
-    slip_arch_writeb('\r');     /* Type debug line == '\r' */
-    debug_frame = 1;
-  }
-
-  /* Need to also print '\n' because for example COOJA will not show
-     any output before line end */
-  slip_arch_writeb((char)c);
+  debug_line[debug_len++] = (uint8_t)c;
 
   /*
-   * Line buffered output, a newline marks the end of debug output and
-   * implicitly flushes debug output.
+   * Line buffered output, a newline (or a full line buffer) sends the
+   * line as one debug frame. Need to also print '\n' because for example
+   * COOJA will not show any output before line end.
    */
-  if(c == '\n') {
-    slip_arch_writeb(SLIP_END);
-    debug_frame = 0;
+  if(c == '\n' || debug_len == sizeof(debug_line)) {
+    frame_begin();
+    slip_arch_writeb('\r');     /* Type debug line == '\r' */
+    frame_data(debug_line, debug_len);
+    frame_end();
+    debug_len = 0;
   }
   return c;
 }
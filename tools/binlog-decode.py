@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+Decode the binary log of a mote (apps_contiki_master/binlog).
+
+Reads the serial output of the mote (or the output of tunslip6 for a
+border router) on stdin and prints it with the "#B" lines replaced by
+the text of their event. The events come from the binlog-events.h of the
+firmware:
+
+    #define EV_SAMPLE  1  /* sampled temperature %d (x100) at %d s */
+
+Example:
+
+    make connect-router | tools/binlog-decode.py "Mote 1 - Border router/binlog-events.h"
+"""
+
+import argparse
+import re
+import sys
+
+EVENT_RE = re.compile(r'#define\s+(\w+)\s+(\d+)\s*/\*\s*(.*?)\s*\*/')
+DROPPED = 0
+
+
+def load_events(paths):
+    events = {DROPPED: ('BINLOG_DROPPED', '%d events lost')}
+    for path in paths:
+        with open(path) as f:
+            for line in f:
+                m = EVENT_RE.search(line)
+                if m:
+                    events[int(m.group(2))] = (m.group(1), m.group(3))
+    return events
+
+
+def varints(data):
+    """Zigzag LEB128 varints to signed integers."""
+    value = shift = 0
+    for b in data:
+        value |= (b & 0x7f) << shift
+        shift += 7
+        if not b & 0x80:
+            yield (value >> 1) ^ -(value & 1)
+            value = shift = 0
+
+
+class Decoder:
+    def __init__(self, events, hz):
+        self.events = events
+        self.hz = hz
+        self.ticks = None   # unwrapped clock_time() of the last record
+
+    def time(self, low):
+        if self.ticks is None:
+            self.ticks = low
+        else:
+            self.ticks += (low - self.ticks) & 0xffff
+        return self.ticks / self.hz
+
+    def decode(self, record):
+        if len(record) < 4 or len(record) != 4 + record[1]:
+            raise ValueError('bad length')
+        event = record[0]
+        args = tuple(varints(record[4:]))
+        when = self.time(record[2] | record[3] << 8)
+        name, fmt = self.events.get(event, ('EV_%d' % event, None))
+        if fmt is None:
+            text = ' '.join(str(a) for a in args)
+        else:
+            try:
+                text = fmt % args
+            except (TypeError, ValueError):
+                text = '%s %r' % (fmt, args)
+        return '%10.3f %s: %s' % (when, name, text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[1])
+    parser.add_argument('headers', nargs='+',
+                        help='binlog-events.h of the firmware')
+    parser.add_argument('--hz', type=int, default=128,
+                        help='CLOCK_SECOND of the platform (128 on Z1)')
+    opts = parser.parse_args()
+
+    decoder = Decoder(load_events(opts.headers), opts.hz)
+    for line in sys.stdin:
+        pos = line.find('#B')
+        if pos < 0:
+            sys.stdout.write(line)
+            continue
+        try:
+            record = bytes.fromhex(line[pos + 2:].strip())
+            line = line[:pos] + decoder.decode(record) + '\n'
+        except ValueError:
+            pass
+        sys.stdout.write(line)
+        sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()
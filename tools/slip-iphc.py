@@ -0,0 +1,440 @@
+#!/usr/bin/env python3
+"""
+Compress the headers on the SLIP link of a border router (slip-iphc).
+
+Sits between the serial line of the border router and tunslip6, which is
+given a pseudo terminal instead of the serial device. The border router is
+asked to compress its packets (?H) and they are restored before tunslip6
+sees them. Once the border router has acknowledged (!H1), the packets of
+the host are compressed too. Context 0 is the prefix given with -p, or
+the one tunslip6 sends (!P). Everything else goes through unchanged, and
+the border router is told to stop compressing (!H0) when this exits.
+
+The other configuration requests of the border router (?<key><seq>) are
+answered here when the value is given, with the sequence number of the
+request (!<key><seq><value>): the radio channel with -c (C) and the RPL
+instance, DIO interval min and doublings with -d (D). Without them the
+request goes on to tunslip6, and the border router keeps its defaults.
+
+The command after "--" is run with "{}" replaced by the pseudo terminal,
+relative to /dev as tunslip6 -s expects it:
+
+    tools/slip-iphc.py -s /dev/ttyUSB0 -p aaaa::1/64 -- \
+        sudo tunslip6 -s {} aaaa::1/64
+
+The encoding is the one of apps_contiki_master/slip-iphc/slip-iphc.c.
+"""
+
+import argparse
+import os
+import select
+import socket
+import struct
+import subprocess
+import sys
+import termios
+import tty
+
+SLIP_END = 0o300
+SLIP_ESC = 0o333
+SLIP_ESC_END = 0o334
+SLIP_ESC_ESC = 0o335
+
+IPHC_DISPATCH = 0x60
+IPHC_DISPATCH_MASK = 0xe0
+IPHC_TF_MASK = 0x18
+IPHC_TF_TC = 0x10
+IPHC_TF_ELIDED = 0x18
+IPHC_NH = 0x04
+IPHC_HLIM_MASK = 0x03
+IPHC_HLIM = {1: 0x01, 64: 0x02, 255: 0x03}
+HLIM_TTL = {v: k for k, v in IPHC_HLIM.items()}
+IPHC_CID = 0x80
+IPHC_SRC_SHIFT = 4
+IPHC_M = 0x08
+IPHC_AC = 0x04
+IPHC_AM_MASK = 0x03
+IPHC_AM_128 = 0x00
+IPHC_AM_64 = 0x01
+IPHC_AM_16 = 0x02
+IPHC_AM_MCAST_8 = 0x03
+
+NHC_UDP = 0xf0
+NHC_UDP_MASK = 0xf8
+NHC_UDP_PORTS_MASK = 0x03
+NHC_UDP_PORTS_16 = 0x00
+NHC_UDP_DST_8 = 0x01
+NHC_UDP_SRC_8 = 0x02
+NHC_UDP_PORTS_4 = 0x03
+NHC_UDP_PORT_8 = 0xf000
+NHC_UDP_PORT_4 = 0xf0b0
+
+IPH_LEN = 40
+UDPH_LEN = 8
+PROTO_UDP = 17
+
+LINK_LOCAL = bytes([0xfe, 0x80]) + bytes(6)
+IID_16 = bytes([0, 0, 0, 0xff, 0xfe, 0])
+
+
+class Codec:
+    """IPHC and UDP NHC of RFC 6282, as far as slip-iphc.c uses them."""
+
+    def __init__(self):
+        self.context = None   # prefix of context 0
+
+    def is_compressed(self, packet):
+        return (len(packet) > 0
+                and packet[0] & IPHC_DISPATCH_MASK == IPHC_DISPATCH
+                and packet[0] & IPHC_TF_TC != 0)
+
+    def compress_addr(self, addr, out, source):
+        if source and addr == bytes(16):
+            return IPHC_AC | IPHC_AM_128
+        if addr[:8] == LINK_LOCAL:
+            mode = 0
+        elif self.context is not None and addr[:8] == self.context:
+            mode = IPHC_AC
+        else:
+            out += addr
+            return IPHC_AM_128
+        if addr[8:14] == IID_16:
+            out += addr[14:]
+            return mode | IPHC_AM_16
+        out += addr[8:]
+        return mode | IPHC_AM_64
+
+    def compress_dest(self, addr, out):
+        if addr[0] != 0xff:
+            return self.compress_addr(addr, out, False)
+        if addr[1] == 0x02 and addr[2:15] == bytes(13):
+            out.append(addr[15])
+            return IPHC_M | IPHC_AM_MCAST_8
+        out += addr
+        return IPHC_M | IPHC_AM_128
+
+    def compress(self, packet):
+        """Return the compressed packet, or None to send it as it is."""
+        if (len(packet) < IPH_LEN or packet[0] & 0xf0 != 0x60
+                or packet[1] & 0x0f or packet[2] or packet[3]):
+            return None
+        proto, ttl = packet[6], packet[7]
+        hdr = bytearray([IPHC_DISPATCH, 0])
+        tc = (packet[0] << 4 | packet[1] >> 4) & 0xff
+        if tc == 0:
+            hdr[0] |= IPHC_TF_ELIDED
+        else:
+            hdr[0] |= IPHC_TF_TC
+            hdr.append((tc << 6 | tc >> 2) & 0xff)
+
+        udp = proto == PROTO_UDP and len(packet) >= IPH_LEN + UDPH_LEN
+        if udp:
+            hdr[0] |= IPHC_NH
+        else:
+            hdr.append(proto)
+
+        if ttl in IPHC_HLIM:
+            hdr[0] |= IPHC_HLIM[ttl]
+        else:
+            hdr.append(ttl)
+
+        hdr[1] = self.compress_addr(packet[8:24], hdr, True) << IPHC_SRC_SHIFT
+        hdr[1] |= self.compress_dest(packet[24:40], hdr)
+
+        if not udp:
+            return bytes(hdr) + packet[IPH_LEN:]
+
+        src, dst = struct.unpack('!HH', packet[IPH_LEN:IPH_LEN + 4])
+        nhc = len(hdr)
+        hdr.append(NHC_UDP)
+        if src & 0xfff0 == NHC_UDP_PORT_4 and dst & 0xfff0 == NHC_UDP_PORT_4:
+            hdr[nhc] |= NHC_UDP_PORTS_4
+            hdr.append((src & 0x0f) << 4 | dst & 0x0f)
+        elif dst & 0xff00 == NHC_UDP_PORT_8:
+            hdr[nhc] |= NHC_UDP_DST_8
+            hdr += struct.pack('!HB', src, dst & 0xff)
+        elif src & 0xff00 == NHC_UDP_PORT_8:
+            hdr[nhc] |= NHC_UDP_SRC_8
+            hdr += struct.pack('!BH', src & 0xff, dst)
+        else:
+            hdr += struct.pack('!HH', src, dst)
+        hdr += packet[IPH_LEN + 6:IPH_LEN + 8]
+        return bytes(hdr) + packet[IPH_LEN + UDPH_LEN:]
+
+    def decompress_addr(self, data, pos, mode):
+        """Return the address and the position after it."""
+        if mode & IPHC_M:
+            am = mode & IPHC_AM_MASK
+            if mode & IPHC_AC:
+                raise ValueError('multicast context mode')
+            if am == IPHC_AM_128:
+                return data[pos:pos + 16], pos + 16
+            if am == IPHC_AM_MCAST_8:
+                addr = bytes([0xff, 0x02]) + bytes(13) + data[pos:pos + 1]
+                return addr, pos + 1
+            raise ValueError('multicast mode %d' % am)
+
+        if mode & IPHC_AM_MASK == IPHC_AM_128:
+            if mode & IPHC_AC:
+                return bytes(16), pos
+            return data[pos:pos + 16], pos + 16
+
+        if mode & IPHC_AC:
+            if self.context is None:
+                raise ValueError('no context')
+            prefix = self.context
+        else:
+            prefix = LINK_LOCAL
+        if mode & IPHC_AM_MASK == IPHC_AM_64:
+            return prefix + data[pos:pos + 8], pos + 8
+        if mode & IPHC_AM_MASK == IPHC_AM_16:
+            return prefix + IID_16 + data[pos:pos + 2], pos + 2
+        raise ValueError('address from the link layer')
+
+    def decompress(self, data):
+        """Return the IPv6 packet of a compressed packet."""
+        if (len(data) < 2 or not self.is_compressed(data)
+                or data[1] & IPHC_CID):
+            raise ValueError('not compressed')
+        pos = 2
+        tc = 0
+        if data[0] & IPHC_TF_MASK == IPHC_TF_TC:
+            tc = (data[pos] >> 6 | data[pos] << 2) & 0xff
+            pos += 1
+
+        udp = data[0] & IPHC_NH != 0
+        if udp:
+            proto = PROTO_UDP
+        else:
+            proto = data[pos]
+            pos += 1
+
+        hlim = data[0] & IPHC_HLIM_MASK
+        if hlim:
+            ttl = HLIM_TTL[hlim]
+        else:
+            ttl = data[pos]
+            pos += 1
+
+        src, pos = self.decompress_addr(
+            data, pos, data[1] >> IPHC_SRC_SHIFT & (IPHC_AC | IPHC_AM_MASK))
+        dst, pos = self.decompress_addr(data, pos, data[1] & 0x0f)
+
+        udph = b''
+        if udp:
+            nhc = data[pos]
+            pos += 1
+            if nhc & NHC_UDP_MASK != NHC_UDP:
+                raise ValueError('next header 0x%02x' % nhc)
+            ports = nhc & NHC_UDP_PORTS_MASK
+            if ports == NHC_UDP_PORTS_4:
+                sport = NHC_UDP_PORT_4 | data[pos] >> 4
+                dport = NHC_UDP_PORT_4 | data[pos] & 0x0f
+                pos += 1
+            elif ports == NHC_UDP_DST_8:
+                sport, dport = struct.unpack('!HB', data[pos:pos + 3])
+                dport |= NHC_UDP_PORT_8
+                pos += 3
+            elif ports == NHC_UDP_SRC_8:
+                sport, dport = struct.unpack('!BH', data[pos:pos + 3])
+                sport |= NHC_UDP_PORT_8
+                pos += 3
+            else:
+                sport, dport = struct.unpack('!HH', data[pos:pos + 4])
+                pos += 4
+            checksum = data[pos:pos + 2]
+            pos += 2
+            if pos > len(data):
+                raise ValueError('truncated')
+            udph = struct.pack('!HHH', sport, dport,
+                               UDPH_LEN + len(data) - pos) + checksum
+
+        if pos > len(data):
+            raise ValueError('truncated')
+        payload = udph + data[pos:]
+        iph = struct.pack('!BBHHBB', 0x60 | tc >> 4, (tc << 4) & 0xff, 0,
+                          len(payload), proto, ttl)
+        return iph + src + dst + payload
+
+
+class SlipReader:
+    """Splits a SLIP byte stream into frames."""
+
+    def __init__(self):
+        self.frame = bytearray()
+        self.esc = False
+
+    def feed(self, data):
+        for b in data:
+            if self.esc:
+                self.esc = False
+                if b == SLIP_ESC_END:
+                    b = SLIP_END
+                elif b == SLIP_ESC_ESC:
+                    b = SLIP_ESC
+                self.frame.append(b)
+            elif b == SLIP_ESC:
+                self.esc = True
+            elif b == SLIP_END:
+                if self.frame:
+                    yield bytes(self.frame)
+                self.frame = bytearray()
+            else:
+                self.frame.append(b)
+
+
+def slip_frame(data):
+    return (bytes([SLIP_END])
+            + data.replace(bytes([SLIP_ESC]), bytes([SLIP_ESC, SLIP_ESC_ESC]))
+                  .replace(bytes([SLIP_END]), bytes([SLIP_ESC, SLIP_ESC_END]))
+            + bytes([SLIP_END]))
+
+
+def write_all(fd, data):
+    while data:
+        data = data[os.write(fd, data):]
+
+
+class Bridge:
+    def __init__(self, serial, pty, codec, config):
+        self.serial = serial
+        self.pty = pty
+        self.codec = codec
+        self.config = config   # key: value of the answer
+        self.enabled = False   # the border router decompresses
+        self.from_mote = SlipReader()
+        self.from_host = SlipReader()
+
+    def request(self):
+        write_all(self.serial, slip_frame(b'?H'))
+
+    def stop(self):
+        write_all(self.serial, slip_frame(b'!H0'))
+
+    def mote_frame(self, frame):
+        if frame[:2] == b'!H':
+            self.enabled = frame[2:3] == b'1'
+            return
+        if frame[:1] == b'?' and len(frame) == 3 and frame[1:2] in self.config:
+            key = frame[1:2]
+            write_all(self.serial,
+                      slip_frame(b'!' + key + frame[2:3] + self.config[key]))
+            return
+        if self.codec.is_compressed(frame):
+            try:
+                frame = self.codec.decompress(frame)
+            except (ValueError, IndexError, struct.error) as e:
+                sys.stderr.write('slip-iphc: bad compressed packet (%s)\n' % e)
+                return
+        write_all(self.pty, slip_frame(frame))
+        if frame[:2] == b'?P':
+            # the border router has just started, and forgot about ?H
+            self.enabled = False
+            self.request()
+
+    def host_frame(self, frame):
+        if frame[:2] == b'!P' and len(frame) >= 10:
+            self.codec.context = frame[2:10]
+        elif self.enabled and frame[0] & 0xf0 == 0x60:
+            frame = self.codec.compress(frame) or frame
+        write_all(self.serial, slip_frame(frame))
+
+    def run(self, child):
+        self.request()
+        while child.poll() is None:
+            ready, _, _ = select.select([self.serial, self.pty], [], [], 1)
+            if self.serial in ready:
+                for frame in self.from_mote.feed(os.read(self.serial, 1024)):
+                    self.mote_frame(frame)
+            if self.pty in ready:
+                try:
+                    data = os.read(self.pty, 1024)
+                except OSError:
+                    # nothing has the other side open (yet)
+                    continue
+                for frame in self.from_host.feed(data):
+                    self.host_frame(frame)
+
+
+def open_serial(path, baudrate):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    speed = getattr(termios, 'B%d' % baudrate)
+    attrs[4] = attrs[5] = speed
+    attrs[2] |= termios.CLOCAL | termios.CREAD
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+def byte_values(text, count, lows, highs):
+    try:
+        values = [int(v) for v in text.split(',')]
+    except ValueError:
+        values = []
+    if (len(values) != count
+            or not all(lo <= v <= hi for v, lo, hi in zip(values, lows, highs))):
+        raise argparse.ArgumentTypeError('invalid value: %s' % text)
+    return bytes(values)
+
+
+def channel(text):
+    return byte_values(text, 1, [11], [26])
+
+
+def dio(text):
+    # a global instance, and a longest interval of 2^(min + doublings) ms
+    # that fits the clock of the border router (2^18 ms on the Z1); a min
+    # of 0 would leave the RPL defaults
+    value = byte_values(text, 3, [0, 1, 0], [127, 18, 18])
+    if value[1] + value[2] > 18:
+        raise argparse.ArgumentTypeError('DIO interval too long: %s' % text)
+    return value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[1])
+    parser.add_argument('-s', dest='device', default='/dev/ttyUSB0',
+                        help='serial device of the border router')
+    parser.add_argument('-B', dest='baudrate', type=int, default=115200,
+                        help='baud rate (SLIP_BRIDGE_CONF_BAUDRATE)')
+    parser.add_argument('-p', dest='prefix',
+                        help='IPv6 prefix of the mesh, e.g. aaaa::1/64')
+    parser.add_argument('-c', dest='channel', type=channel,
+                        help='radio channel of the border router (11-26)')
+    parser.add_argument('-d', dest='dio', type=dio,
+                        help='RPL instance, DIO interval min and doublings, '
+                        'e.g. 30,12,6')
+    parser.add_argument('command', nargs='+',
+                        help='tunslip6 command line, {} is the terminal')
+    opts = parser.parse_args()
+
+    codec = Codec()
+    if opts.prefix:
+        addr = opts.prefix.split('/')[0]
+        codec.context = socket.inet_pton(socket.AF_INET6, addr)[:8]
+
+    config = {}
+    if opts.channel:
+        config[b'C'] = opts.channel
+    if opts.dio:
+        config[b'D'] = opts.dio
+
+    serial = open_serial(opts.device, opts.baudrate)
+    pty, pts = os.openpty()
+    tty.setraw(pty)
+    tty.setraw(pts)
+    name = os.path.relpath(os.ttyname(pts), '/dev')
+    child = subprocess.Popen([a.replace('{}', name) for a in opts.command])
+    bridge = Bridge(serial, pty, codec, config)
+    try:
+        bridge.run(child)
+    except KeyboardInterrupt:
+        child.wait()
+    finally:
+        bridge.stop()
+    sys.exit(child.returncode)
+
+
+if __name__ == '__main__':
+    main()